@@ -0,0 +1,122 @@
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "capture.hpp"
+#include "render.hpp"
+
+
+namespace
+{
+	struct QueuedFrame
+	{
+		long long number;
+		render::Image image;
+	};
+
+
+	std::string capturePath;
+	bool capturing = false;
+	std::thread writerThread;
+	capture::Stats stats;		// frames and dropped are owned by the submitting thread
+
+	// guarded by queueMutex
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;
+	std::deque< QueuedFrame > queue;
+	std::vector< render::Image > freeImages;		// written frames, kept to reuse their storage
+	bool stopping = false;
+	int written = 0;
+	int failed = 0;
+
+
+	void writerLoop()
+	{
+		std::unique_lock< std::mutex > lock( queueMutex );
+		while ( true )
+		{
+			queueChanged.wait( lock, []() { return stopping || !queue.empty(); } );
+			if ( queue.empty() )
+				return;
+
+			// encode and write outside of the lock, submit() only ever waits for the queue itself
+			QueuedFrame frame = std::move( queue.front() );
+			queue.pop_front();
+			lock.unlock();
+			bool ok = render::writeImage( frame.image, render::numberedPath( capturePath.c_str(), frame.number ).c_str() );
+			lock.lock();
+
+			ok ? ++written : ++failed;
+			freeImages.push_back( std::move( frame.image ) );
+		}
+	}
+}
+
+
+namespace capture
+{
+	void begin( char const *path )
+	{
+		assert( !capturing );
+		capturePath = path;
+		capturing = true;
+		stats = Stats();
+		queue.clear();
+		stopping = false;
+		written = 0;
+		failed = 0;
+		writerThread = std::thread( writerLoop );
+	}
+
+
+	void submit( render::Image *image )
+	{
+		assert( capturing );
+		long long number = stats.frames++;
+
+		std::lock_guard< std::mutex > lock( queueMutex );
+		if ( ( int )queue.size() >= QUEUE_SIZE )
+		{
+			++stats.dropped;
+			return;
+		}
+
+		queue.push_back( QueuedFrame{ number, render::Image() } );
+		std::swap( queue.back().image, *image );
+		if ( !freeImages.empty() )
+		{
+			std::swap( *image, freeImages.back() );
+			freeImages.pop_back();
+		}
+		queueChanged.notify_one();
+	}
+
+
+	Stats end()
+	{
+		assert( capturing );
+		{
+			std::lock_guard< std::mutex > lock( queueMutex );
+			stopping = true;
+		}
+		queueChanged.notify_one();
+		writerThread.join();
+		capturing = false;
+
+		stats.written = written;
+		stats.failed = failed;
+		freeImages.clear();
+		return stats;
+	}
+
+
+	bool isCapturing()
+	{
+		return capturing;
+	}
+}
@@ -0,0 +1,35 @@
+namespace render
+{
+	struct Image;
+}
+
+
+//-------------------------------------------------------
+//	frame capture to an image sequence
+//-------------------------------------------------------
+
+namespace capture
+{
+	struct Stats
+	{
+		int frames = 0;			// submitted, including dropped ones
+		int written = 0;
+		int dropped = 0;		// the writer was QUEUE_SIZE frames behind
+		int failed = 0;			// could not be written
+	};
+
+	// frames waiting for the writer thread before new ones are dropped
+	constexpr int QUEUE_SIZE = 8;
+
+	// starts the writer thread, frames go to path with their number added before the extension
+	void begin( char const *path );
+
+	// hands the image to the writer and leaves recycled storage in it, never waits for the disk;
+	// numbers follow submission, so dropped frames show as gaps in the sequence
+	void submit( render::Image *image );
+
+	// writes what is queued, stops the writer thread and returns the totals
+	Stats end();
+
+	bool isCapturing();
+}
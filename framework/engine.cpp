@@ -1,230 +1,583 @@
 
 #include <cassert>
-#include <windows.h>
-#include <windowsx.h>
-#include <GL/gl.h>
-
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "opengl.hpp"
+#include "platform.hpp"
+#include "engine.hpp"
 #include "game.hpp"
 #include "scene.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "jobs.hpp"
+#include "render.hpp"
+#include "capture.hpp"
+#include "hud.hpp"
+#include "memory.hpp"
 
 
 //-------------------------------------------------------
-//	window related stuff
+//	input queue
 //-------------------------------------------------------
 
 namespace
 {
-	HWND windowHandle = nullptr;
+	// window input never calls into the game directly: the window thread pushes events here and
+	// the simulation thread drains them all at the start of its next tick, before updating
+	constexpr unsigned INPUT_QUEUE_SIZE = 256;
+
+	struct QueuedInput
+	{
+		replay::EventType type;
+		int key;
+		float x;
+		float y;
+		long long clockTick;		// when the window reported it, for latency measurement
+	};
+
+	// single producer, single consumer ring; both indices only grow and wrap on overflow
+	QueuedInput inputQueue[ INPUT_QUEUE_SIZE ];
+	std::atomic< unsigned > inputQueueHead( 0 );		// written by the window thread
+	std::atomic< unsigned > inputQueueTail( 0 );		// written by the simulation thread
+
+	// only touched by the simulation thread while it runs
+	long long simulationTick = 0;
+	engine::InputStats inputStats;
+	double inputLatencySum = 0.0;
+
+
+	//-------------------------------------------------------
+	void pushInput( replay::EventType type, int key, float x = 0.f, float y = 0.f )
+	{
+		unsigned head = inputQueueHead.load( std::memory_order_relaxed );
+		if ( head - inputQueueTail.load( std::memory_order_acquire ) == INPUT_QUEUE_SIZE )
+		{
+			// a full queue means the simulation has stalled for hundreds of events, newest input loses
+			inputStats.dropped++;
+			return;
+		}
+
+		QueuedInput &input = inputQueue[ head % INPUT_QUEUE_SIZE ];
+		input.type = type;
+		input.key = key;
+		input.x = x;
+		input.y = y;
+		input.clockTick = platform::clockTicks();
+		inputQueueHead.store( head + 1, std::memory_order_release );
+	}
+
+
+	//-------------------------------------------------------
+	void resetInput()
+	{
+		inputQueueHead.store( 0 );
+		inputQueueTail.store( 0 );
+		inputStats = engine::InputStats();
+		inputLatencySum = 0.0;
+	}
+
+
+	//-------------------------------------------------------
+	void drainInput()
+	{
+		PROFILE_SCOPE( profiler::PHASE_DRAIN_INPUT );
+
+		unsigned tail = inputQueueTail.load( std::memory_order_relaxed );
+		unsigned head = inputQueueHead.load( std::memory_order_acquire );
+		if ( tail == head )
+			return;
+
+		long long now = platform::clockTicks();
+		for ( ; tail != head; ++tail )
+		{
+			QueuedInput const &input = inputQueue[ tail % INPUT_QUEUE_SIZE ];
+
+			// stamped with the ticks completed so far, a replay applies it right before the next one
+			replay::Event event = { simulationTick, input.type, input.key, input.x, input.y };
+			replay::dispatch( event );
+			if ( replay::isRecording() )
+				replay::record( event );
+
+			double latency = ( double )( now - input.clockTick ) / ( double )platform::clockFrequency();
+			inputStats.events++;
+			inputLatencySum += latency;
+			inputStats.maxLatency = std::max( inputStats.maxLatency, latency );
+		}
+		inputStats.meanLatency = inputLatencySum / inputStats.events;
+		inputQueueTail.store( tail, std::memory_order_release );
+	}
+}
 
+
+//-------------------------------------------------------
+//	window related stuff
+//-------------------------------------------------------
+
+namespace
+{
 	constexpr int WINDOW_WIDTH = 1024;
 	constexpr int WINDOW_HEIGHT = 768;
 
 
 	//-------------------------------------------------------
-	LRESULT CALLBACK windowProcedure( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam )
+	int toGameKey( platform::Key key )
 	{
-		switch ( message )
+		if ( key == platform::KEY_W || key == platform::KEY_UP )
+			return game::KEY_FORWARD;
+		if ( key == platform::KEY_S || key == platform::KEY_DOWN )
+			return game::KEY_BACKWARD;
+		if ( key == platform::KEY_A || key == platform::KEY_LEFT )
+			return game::KEY_LEFT;
+		if ( key == platform::KEY_D || key == platform::KEY_RIGHT )
+			return game::KEY_RIGHT;
+		return -1;
+	}
+
+
+	//-------------------------------------------------------
+	int toCameraKey( platform::Key key )
+	{
+		switch ( key )
 		{
-			case WM_DESTROY:
-				PostQuitMessage( 0 );
-				break;
-
-			case WM_KEYDOWN:
-				if ( wParam == 'W' || wParam == VK_UP )
-					game::keyPressed( game::KEY_FORWARD );
-				if ( wParam == 'S' || wParam == VK_DOWN )
-					game::keyPressed( game::KEY_BACKWARD );
-				if ( wParam == 'A' || wParam == VK_LEFT )
-					game::keyPressed( game::KEY_LEFT );
-				if ( wParam == 'D' || wParam == VK_RIGHT )
-					game::keyPressed( game::KEY_RIGHT );
-				if ( wParam == VK_ESCAPE )
-					DestroyWindow( windowHandle );
-				break;
-
-			case WM_KEYUP:
-				if ( wParam == 'W' || wParam == VK_UP )
-					game::keyReleased( game::KEY_FORWARD );
-				if ( wParam == 'S' || wParam == VK_DOWN )
-					game::keyReleased( game::KEY_BACKWARD );
-				if ( wParam == 'A' || wParam == VK_LEFT )
-					game::keyReleased( game::KEY_LEFT );
-				if ( wParam == 'D' || wParam == VK_RIGHT )
-					game::keyReleased( game::KEY_RIGHT );
-				if ( wParam == VK_SPACE )
-				{
-					game::deinit();
-					game::init();
-				}
-				break;
-
-			case WM_LBUTTONUP:
-			case WM_RBUTTONUP:
-				game::mouseClicked( ( float )( GET_X_LPARAM( lParam ) ) / WINDOW_WIDTH,
-									1.f - ( float )( GET_Y_LPARAM( lParam ) ) / WINDOW_HEIGHT,
-									message == WM_LBUTTONUP );
-				break;
+			case platform::KEY_J:	return scene::CAMERA_PAN_LEFT;
+			case platform::KEY_L:	return scene::CAMERA_PAN_RIGHT;
+			case platform::KEY_I:	return scene::CAMERA_PAN_UP;
+			case platform::KEY_K:	return scene::CAMERA_PAN_DOWN;
+			case platform::KEY_U:	return scene::CAMERA_ZOOM_IN;
+			case platform::KEY_O:	return scene::CAMERA_ZOOM_OUT;
+			default:				return -1;
 		}
-		return DefWindowProc( hwnd, message, wParam, lParam );
 	}
 
 
 	//-------------------------------------------------------
-	void initWindow()
+	void keyPressed( platform::Key key, bool isRepeat )
+	{
+		// auto-repeat changes nothing in the game, keep it out of recordings
+		if ( toGameKey( key ) >= 0 && !isRepeat )
+			pushInput( replay::EVENT_KEY_PRESSED, toGameKey( key ) );
+		if ( toCameraKey( key ) >= 0 && !isRepeat )
+			pushInput( replay::EVENT_CAMERA_KEY_PRESSED, toCameraKey( key ) );
+
+		// the overlay is drawn on this thread and is not part of the game, so not recorded either
+		if ( key == platform::KEY_H && !isRepeat )
+			hud::setVisible( !hud::isVisible() );
+		if ( key == platform::KEY_ESCAPE )
+			platform::closeWindow();
+	}
+
+
+	//-------------------------------------------------------
+	void keyReleased( platform::Key key )
+	{
+		if ( toGameKey( key ) >= 0 )
+			pushInput( replay::EVENT_KEY_RELEASED, toGameKey( key ) );
+		if ( toCameraKey( key ) >= 0 )
+			pushInput( replay::EVENT_CAMERA_KEY_RELEASED, toCameraKey( key ) );
+		if ( key == platform::KEY_SPACE )
+			pushInput( replay::EVENT_RESTART, 0 );
+	}
+
+
+	//-------------------------------------------------------
+	void mouseClicked( float x, float y, bool isLeftButton )
 	{
-		WNDCLASSEX windowClass;
+		pushInput( replay::EVENT_MOUSE_CLICKED, isLeftButton ? 1 : 0, x, y );
+	}
+
+
+	//-------------------------------------------------------
+	bool initWindow( bool offscreen )
+	{
+		platform::WindowListener listener = { keyPressed, keyReleased, mouseClicked };
+		return platform::initWindow( WINDOW_WIDTH, WINDOW_HEIGHT, "World of Tinyships [CLOSED ALPHA]", listener, offscreen );
+	}
 
-		windowClass.cbSize = sizeof( windowClass );
-		windowClass.hInstance = GetModuleHandle( nullptr );
-		windowClass.lpszClassName = "WoTS_WndClass";
-		windowClass.lpfnWndProc = windowProcedure;
-		windowClass.style = CS_DBLCLKS;
 
-		windowClass.hIcon = nullptr;
-		windowClass.hIconSm = nullptr;
-		windowClass.hCursor = LoadCursor( nullptr, IDC_ARROW );
-		windowClass.lpszMenuName = nullptr;
-		windowClass.cbClsExtra = 0;
-		windowClass.cbWndExtra = 0;
-		windowClass.hbrBackground = nullptr;
+	//-------------------------------------------------------
+	bool processWindowMessages()
+	{
+		PROFILE_SCOPE( profiler::PHASE_WINDOW_MESSAGES );
+		return platform::processWindowMessages();
+	}
+}
 
-		RegisterClassEx( &windowClass );
 
-		RECT windowRect;
-		windowRect.left = windowRect.top = 0;
-		windowRect.bottom = WINDOW_HEIGHT;
-		windowRect.right = WINDOW_WIDTH;
-		AdjustWindowRect( &windowRect, WS_CAPTION | WS_SYSMENU, FALSE );
+//-------------------------------------------------------
+//	opengl related stuff
+//-------------------------------------------------------
 
-		int screenWidth = GetSystemMetrics( SM_CXFULLSCREEN );
-		int screenHeight = GetSystemMetrics( SM_CYFULLSCREEN );
+namespace
+{
+	render::Renderer *renderer = nullptr;
 
-		windowHandle = CreateWindowEx( 0, "WoTS_WndClass", "World of Tinyships [CLOSED ALPHA]", WS_CAPTION | WS_SYSMENU,
-								screenWidth / 2 - WINDOW_WIDTH / 2, screenHeight / 2 - WINDOW_HEIGHT / 2, windowRect.right - windowRect.left, windowRect.bottom - windowRect.top,
-								HWND_DESKTOP, nullptr, GetModuleHandle( nullptr ), nullptr );
+	// swapped with recycled storage by every submit
+	render::Image captureImage;
+	engine::CaptureStats captureStats;
 
-		ShowWindow( windowHandle, SW_SHOW );
+
+	//-------------------------------------------------------
+	void captureFrame()
+	{
+		PROFILE_SCOPE( profiler::PHASE_CAPTURE );
+		if ( renderer->captureFrame( &captureImage ) )
+			capture::submit( &captureImage );
 	}
 
 
 	//-------------------------------------------------------
-	void deinitWindow()
+	void endCapture()
 	{
-		DestroyWindow( windowHandle );
+		while ( renderer->finishCapture( &captureImage ) )
+			capture::submit( &captureImage );
+
+		capture::Stats stats = capture::end();
+		captureStats.frames = stats.frames;
+		captureStats.written = stats.written;
+		captureStats.dropped = stats.dropped;
+		captureStats.failed = stats.failed;
 	}
 
 
 	//-------------------------------------------------------
-	bool processWindowMessages()
+	void draw( double renderTick )
 	{
-		MSG msg;
-		while ( PeekMessage( &msg, nullptr, 0, 0, PM_REMOVE ) )
+		scene::draw( renderTick, *renderer );
+		if ( capture::isCapturing() )
+			captureFrame();
 		{
-			if ( msg.message == WM_QUIT )
-				return false;
-			TranslateMessage( &msg );
-			DispatchMessage( &msg );
+			PROFILE_SCOPE( profiler::PHASE_SWAP_BUFFERS );
+			platform::swapBuffers();
 		}
-		return true;
+
+		assert( glGetError() == 0 );
 	}
 }
 
 
 //-------------------------------------------------------
-//	opengl related stuff
+//	update and time related stuff
 //-------------------------------------------------------
 
 namespace
 {
-	HDC windowDC = nullptr;
-	HGLRC openGLHandle = nullptr;
+	constexpr int MAX_FPS = 150;
+
+	long long clockLastTick = 0;
 
 
 	//-------------------------------------------------------
-	void initOGL()
+	void initClock()
 	{
-		windowDC = GetDC( windowHandle );
+		clockLastTick = platform::clockTicks();
+	}
 
-		PIXELFORMATDESCRIPTOR pfd;
-		memset( &pfd, 0, sizeof( pfd ) );
-		pfd.nSize = sizeof( pfd );
-		pfd.nVersion = 1;
-		pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
-		pfd.iPixelType = PFD_TYPE_RGBA;
-		pfd.iLayerType = PFD_MAIN_PLANE;
-		int npfd = ChoosePixelFormat( windowDC, &pfd );
 
-		memset( &pfd, 0, sizeof( pfd ) );
-		pfd.nSize = sizeof( pfd );
-		SetPixelFormat( windowDC, npfd, &pfd );
+	//-------------------------------------------------------
+	double secondsBetween( long long start, long long end )
+	{
+		return ( double )( end - start ) / ( double )platform::clockFrequency();
+	}
 
-		openGLHandle = wglCreateContext( windowDC );
-		wglMakeCurrent( windowDC, openGLHandle );
+
+	//-------------------------------------------------------
+	double secondsSince( long long start )
+	{
+		return secondsBetween( start, platform::clockTicks() );
 	}
 
 
 	//-------------------------------------------------------
-	void deinitOGL()
+	long long clockAfter( long long start, double seconds )
 	{
-		wglMakeCurrent( nullptr, nullptr );
-		wglDeleteContext( openGLHandle );
-		ReleaseDC( windowHandle, windowDC );
-		openGLHandle = nullptr;
-		windowDC = nullptr;
+		return start + ( long long )( seconds * ( double )platform::clockFrequency() );
 	}
 
 
+	engine::TimeStepPolicy timeStepPolicy;
+	engine::TimeStepStats timeStepStats;
+
+
 	//-------------------------------------------------------
-	void draw()
+	void initTimeStep()
 	{
-		scene::draw();
-		SwapBuffers( windowDC );
+		timeStepStats = engine::TimeStepStats();
+		scene::setSpawnLimit( timeStepPolicy.maxSeaParticlesPerUpdate );
+	}
 
-		assert( glGetError() == 0 );
+
+	//-------------------------------------------------------
+	void simulate( float dt )
+	{
+		// long ticks make aircraft overshoot their targets, they are split into bounded substeps
+		int substeps = std::max( ( int )std::ceil( dt / timeStepPolicy.maxStepTime ), 1 );
+		if ( substeps > 1 )
+			timeStepStats.splitTicks++;
+		if ( substeps > timeStepPolicy.maxSubsteps )
+		{
+			substeps = timeStepPolicy.maxSubsteps;
+			timeStepStats.droppedTime += dt - substeps * timeStepPolicy.maxStepTime;
+			dt = substeps * timeStepPolicy.maxStepTime;
+		}
+
+		float stepTime = dt / substeps;
+		for ( int substep = 0; substep < substeps; ++substep )
+		{
+			{
+				PROFILE_SCOPE( profiler::PHASE_GAME_UPDATE );
+				game::update( stepTime );
+			}
+			{
+				PROFILE_SCOPE( profiler::PHASE_SCENE_UPDATE );
+				scene::update( stepTime );
+			}
+		}
 	}
+
 }
 
 
 //-------------------------------------------------------
-//	update and time related stuff
+//	frame pacing
 //-------------------------------------------------------
 
 namespace
 {
-	constexpr int MAX_FPS = 150;
+	// sleeps in 1 ms slices while far from the deadline; whatever the scheduler
+	// oversleeps on top of that is learned and left to the spin phase
+	constexpr int SLEEP_SLICE_MS = 1;
+	constexpr double MIN_SPIN_TIME = 0.0002;
+	constexpr double SLEEP_OVERSHOOT_DECAY = 0.99;
+
+	// learned per thread, render and simulation threads are paced independently
+	thread_local double sleepOvershoot = 0.001;
 
-	LARGE_INTEGER clockFrequency;
-	LARGE_INTEGER clockLastTick;
+	engine::PacingStats pacingStats;
+	double frameTimeMean = 0.0;
+	double frameTimeM2 = 0.0;
 
 
 	//-------------------------------------------------------
-	void initClock()
+	void initPacer()
 	{
-		QueryPerformanceFrequency( &clockFrequency );
-		QueryPerformanceCounter( &clockLastTick );
+		platform::beginFinePacing();
+		pacingStats = engine::PacingStats();
+		pacingStats.targetFrameTime = 1.0 / MAX_FPS;
+		frameTimeMean = 0.0;
+		frameTimeM2 = 0.0;
 	}
 
 
 	//-------------------------------------------------------
-	void update()
+	void deinitPacer()
 	{
-		float dt = 0.f;
+		platform::endFinePacing();
+	}
+
+
+	//-------------------------------------------------------
+	void recordFrameTime( double frameTime, double sleepTime, double spinTime )
+	{
+		// Welford's running variance, the standard deviation of frame time is the jitter
+		pacingStats.frames++;
+		double delta = frameTime - frameTimeMean;
+		frameTimeMean += delta / pacingStats.frames;
+		frameTimeM2 += delta * ( frameTime - frameTimeMean );
+
+		pacingStats.meanFrameTime = frameTimeMean;
+		pacingStats.jitter = pacingStats.frames > 1 ? std::sqrt( frameTimeM2 / ( pacingStats.frames - 1 ) ) : 0.0;
+		pacingStats.maxDeviation = std::max( pacingStats.maxDeviation, std::abs( frameTime - pacingStats.targetFrameTime ) );
+		pacingStats.sleepTime += sleepTime;
+		pacingStats.spinTime += spinTime;
+	}
+
 
-		while ( true )
+	//-------------------------------------------------------
+	long long waitUntil( long long deadline, double *sleepTime, double *spinTime )
+	{
+		*sleepTime = 0.0;
+
+		long long clockTick = platform::clockTicks();
+		while ( secondsBetween( clockTick, deadline ) > sleepOvershoot + MIN_SPIN_TIME )
 		{
-			LARGE_INTEGER clockTick;
-			QueryPerformanceCounter( &clockTick );
-			double deltaTime = ( double )( clockTick.QuadPart - clockLastTick.QuadPart ) / ( double )clockFrequency.QuadPart;
-			if ( deltaTime >= 1.0 / MAX_FPS )
+			long long sleepStart = clockTick;
+			platform::sleepMilliseconds( SLEEP_SLICE_MS );
+			clockTick = platform::clockTicks();
+
+			double slept = secondsBetween( sleepStart, clockTick );
+			double overshoot = slept - SLEEP_SLICE_MS * 0.001;
+			sleepOvershoot = std::max( overshoot, sleepOvershoot * SLEEP_OVERSHOOT_DECAY );
+			*sleepTime += slept;
+		}
+
+		long long spinStart = clockTick;
+		while ( clockTick < deadline )
+			clockTick = platform::clockTicks();
+		*spinTime = secondsBetween( spinStart, clockTick );
+
+		return clockTick;
+	}
+
+
+	//-------------------------------------------------------
+	void waitForNextFrame()
+	{
+		double sleepTime = 0.0;
+		double spinTime = 0.0;
+		long long clockTick = waitUntil( clockAfter( clockLastTick, 1.0 / MAX_FPS ), &sleepTime, &spinTime );
+
+		recordFrameTime( secondsBetween( clockLastTick, clockTick ), sleepTime, spinTime );
+		clockLastTick = clockTick;
+	}
+}
+
+
+//-------------------------------------------------------
+//	simulation thread
+//-------------------------------------------------------
+
+namespace
+{
+	std::thread simulationThread;
+	std::atomic< bool > simulationRunning( false );
+	// moved forward when the simulation falls too far behind, read by the render thread
+	std::atomic< long long > simulationStart( 0 );
+
+
+	//-------------------------------------------------------
+	void simulationLoop()
+	{
+		while ( simulationRunning.load( std::memory_order_relaxed ) )
+		{
+			// tick N is due N tick times after the start, rendering relies on that schedule
+			long long due = clockAfter( simulationStart.load(), ( double )( simulationTick + 1 ) * engine::SIM_TICK_TIME );
+			double lag = secondsSince( due );
+			if ( lag > timeStepPolicy.maxLag )
 			{
-				dt = ( float )deltaTime;
-				clockLastTick = clockTick;
-				break;
+				// after a stall, catch up on at most maxLag worth of ticks and give up on the rest
+				// of the backlog instead of running hundreds of ticks back to back
+				double dropped = lag - timeStepPolicy.maxLag;
+				simulationStart.fetch_add( clockAfter( 0, dropped ) );
+				timeStepStats.droppedTime += dropped;
+				lag = timeStepPolicy.maxLag;
 			}
+			if ( lag > engine::SIM_TICK_TIME )
+				timeStepStats.catchUpTicks++;
+
+			double sleepTime = 0.0;
+			double spinTime = 0.0;
+			waitUntil( clockAfter( simulationStart.load(), ( double )( simulationTick + 1 ) * engine::SIM_TICK_TIME ), &sleepTime, &spinTime );
+
+			// counted on every thread, so allocations the render thread makes meanwhile show up here too
+			long long allocations = memory::allocationCount();
+			profiler::beginFrame( profiler::TRACK_SIMULATION );
+			drainInput();
+			simulate( engine::SIM_TICK_TIME );
+			scene::publishSnapshot( ++simulationTick );
+			profiler::addCount( profiler::COUNTER_ALLOCATIONS, memory::allocationCount() - allocations );
+			profiler::endFrame();
 		}
+	}
+
 
-		game::update( dt );
-		scene::update( dt );
+	//-------------------------------------------------------
+	void startSimulation()
+	{
+		simulationStart = platform::clockTicks();
+		simulationTick = 0;
+		scene::publishSnapshot( 0 );
+		simulationRunning.store( true );
+		simulationThread = std::thread( simulationLoop );
+	}
+
+
+	//-------------------------------------------------------
+	void stopSimulation()
+	{
+		simulationRunning.store( false );
+		simulationThread.join();
+	}
+
+
+	//-------------------------------------------------------
+	double simulationTicksElapsed()
+	{
+		return secondsSince( simulationStart ) / engine::SIM_TICK_TIME;
+	}
+}
+
+
+//-------------------------------------------------------
+//	headless simulation
+//-------------------------------------------------------
+
+namespace
+{
+	engine::HeadlessRendering headlessRendering;
+
+
+	//-------------------------------------------------------
+	// draws the state right after the tick like the window would, on the CPU
+	bool renderHeadless( render::Renderer &software, long long tick )
+	{
+		// a whole tick past the snapshot, interpolation lands exactly on its latest state
+		scene::publishSnapshot( tick );
+		profiler::beginFrame( profiler::TRACK_RENDER );
+		scene::draw( ( double )( tick + 1 ), software );
+		profiler::endFrame();
+
+		render::Image image;
+		software.readFrame( &image );
+		return render::writeImage( image, render::numberedPath( headlessRendering.path, tick ).c_str() );
+	}
+
+
+	//-------------------------------------------------------
+	engine::HeadlessStats simulateHeadless( long long tickCount, float tickTime, replay::Log const *log )
+	{
+		assert( tickCount >= 0 );
+		assert( tickTime > 0.f );
+
+		initClock();
+		initTimeStep();
+		long long startTick = clockLastTick;
+
+		std::unique_ptr< render::Renderer > software;
+		if ( headlessRendering.path && headlessRendering.interval > 0 )
+			software.reset( render::createSoftwareRenderer( WINDOW_WIDTH, WINDOW_HEIGHT ) );
+		int imagesFailed = 0;
+
+		jobs::init();
+		game::init();
+		size_t nextEvent = 0;
+		for ( long long tick = 0; tick < tickCount; ++tick )
+		{
+			long long allocations = memory::allocationCount();
+			profiler::beginFrame( profiler::TRACK_SIMULATION );
+			while ( log && nextEvent < log->events.size() && log->events[ nextEvent ].tick <= tick )
+				replay::dispatch( log->events[ nextEvent++ ] );
+			simulate( tickTime );
+			profiler::addCount( profiler::COUNTER_ALLOCATIONS, memory::allocationCount() - allocations );
+			profiler::endFrame();
+
+			if ( software && ( tick + 1 ) % headlessRendering.interval == 0 && !renderHeadless( *software, tick + 1 ) )
+				++imagesFailed;
+		}
+		game::deinit();
+		jobs::deinit();
+
+		engine::HeadlessStats stats;
+		stats.ticks = ( int )tickCount;
+		stats.simulatedTime = ( double )tickCount * tickTime;
+		stats.wallTime = secondsSince( startTick );
+		stats.imagesFailed = imagesFailed;
+		return stats;
 	}
 }
 
@@ -235,19 +588,126 @@ namespace
 
 namespace engine
 {
-	void run()
+	bool run( RunSettings const &settings )
 	{
-		initWindow();
-		initOGL();
+		if ( !initWindow( settings.offscreen ) )
+			return false;
+		bool core = settings.renderer == RENDERER_CORE;
+		if ( !platform::initOGL( core ? platform::CONTEXT_CORE : platform::CONTEXT_COMPATIBILITY ) )
+		{
+			platform::deinitWindow();
+			return false;
+		}
+
+		// without instancing the legacy renderer draws meshes in immediate mode, the core one has no fallback
+		renderer = core ? render::createCoreOpenGLRenderer() : render::createOpenGLRenderer();
+		if ( !renderer )
+		{
+			platform::deinitOGL();
+			platform::deinitWindow();
+			return false;
+		}
+
 		initClock();
+		initPacer();
+		initTimeStep();
+		resetInput();
+		jobs::init();
 		game::init();
-		while ( processWindowMessages() )
+		if ( settings.recordPath )
+			replay::beginRecording();
+		captureStats = CaptureStats();
+		if ( settings.capturePath )
+			capture::begin( settings.capturePath );
+		startSimulation();
+		profiler::beginFrame( profiler::TRACK_RENDER );
+		for ( int frame = 1; processWindowMessages(); ++frame )
 		{
-			update();
-			draw();
+			waitForNextFrame();
+			draw( simulationTicksElapsed() );
+			profiler::endFrame();
+			if ( frame == settings.frameLimit )
+				platform::closeWindow();
+			profiler::beginFrame( profiler::TRACK_RENDER );
 		}
+		profiler::endFrame();
+		stopSimulation();
 		game::deinit();
-		deinitOGL();
-		deinitWindow();
+		jobs::deinit();
+		deinitPacer();
+		if ( capture::isCapturing() )
+			endCapture();
+		delete renderer;
+		renderer = nullptr;
+		platform::deinitOGL();
+		platform::deinitWindow();
+
+		return !settings.recordPath || replay::saveRecording( settings.recordPath, simulationTick, SIM_TICK_TIME );
+	}
+
+
+	HeadlessStats runHeadless( int tickCount, float tickTime )
+	{
+		return simulateHeadless( tickCount, tickTime, nullptr );
+	}
+
+
+	HeadlessStats runHeadlessFor( float duration, float tickTime )
+	{
+		return simulateHeadless( ( long long )std::ceil( duration / tickTime ), tickTime, nullptr );
+	}
+
+
+	bool runReplay( char const *path, HeadlessStats *stats )
+	{
+		replay::Log log;
+		if ( !replay::load( path, &log ) )
+			return false;
+		*stats = simulateHeadless( log.tickCount, log.tickTime, &log );
+		return true;
+	}
+
+
+	PacingStats getPacingStats()
+	{
+		return pacingStats;
+	}
+
+
+	InputStats getInputStats()
+	{
+		return inputStats;
+	}
+
+
+	CaptureStats getCaptureStats()
+	{
+		return captureStats;
+	}
+
+
+	void setHeadlessRendering( HeadlessRendering const &rendering )
+	{
+		assert( !rendering.path || rendering.interval > 0 );
+		headlessRendering = rendering;
+	}
+
+
+	void setTimeStepPolicy( TimeStepPolicy const &policy )
+	{
+		assert( policy.maxStepTime > 0.f && policy.maxSubsteps > 0 && policy.maxLag >= 0.f );
+		timeStepPolicy = policy;
+	}
+
+
+	void setHudVisible( bool visible )
+	{
+		hud::setVisible( visible );
+	}
+
+
+	TimeStepStats getTimeStepStats()
+	{
+		return timeStepStats;
 	}
 }
@@ -2,6 +2,106 @@
 
 namespace engine
 {
-	void run();
-}
+	// simulation runs in fixed ticks independent of the render rate
+	constexpr float SIM_TICK_TIME = 1.f / 60.f;
+
+	struct HeadlessStats
+	{
+		int ticks;
+		double simulatedTime;
+		double wallTime;
+		int imagesFailed;				// headless renderings that could not be written
+	};
+
+	struct PacingStats
+	{
+		int frames = 0;
+		double targetFrameTime = 0.0;
+		double meanFrameTime = 0.0;
+		double jitter = 0.0;			// standard deviation of the frame time
+		double maxDeviation = 0.0;		// worst distance from the target frame time
+		double sleepTime = 0.0;			// total time the main thread gave back to the OS
+		double spinTime = 0.0;			// total time burnt on the clock in the last sub-millisecond
+	};
+
+	struct InputStats
+	{
+		int events = 0;					// input events applied to the game
+		int dropped = 0;				// events lost to a full input queue
+		double meanLatency = 0.0;		// from the window reporting an event to the simulation applying it
+		double maxLatency = 0.0;
+	};
+
+	struct CaptureStats
+	{
+		int frames = 0;					// rendered while capturing
+		int written = 0;
+		int dropped = 0;				// not written because the disk fell behind
+		int failed = 0;					// could not be written
+	};
+
+	// limits that keep one long frame from cascading into several slow ones
+	struct TimeStepPolicy
+	{
+		float maxStepTime = 1.f / 30.f;		// longer ticks are split into substeps
+		int maxSubsteps = 4;				// tick time beyond that many substeps is dropped
+		float maxLag = 0.25f;				// how far the simulation thread may fall behind the clock
+		int maxSeaParticlesPerUpdate = 8;	// spawns beyond that in one scene update are dropped
+	};
+
+	struct TimeStepStats
+	{
+		int splitTicks = 0;				// ticks longer than maxStepTime
+		int catchUpTicks = 0;			// ticks run more than a tick late, back to back
+		double droppedTime = 0.0;		// simulation seconds given up to stay within the policy
+	};
+
+	// how the window is drawn, chosen at start up to compare their frame cost
+	enum RendererBackend
+	{
+		RENDERER_LEGACY,	// fixed function pipeline with instanced meshes, immediate mode without instancing
+		RENDERER_CORE,		// OpenGL 3.3 core profile, shaders and buffers only
+	};
+
+	struct RunSettings
+	{
+		char const *recordPath = nullptr;	// records every input event there if given
+		char const *capturePath = nullptr;	// writes every rendered frame there as a numbered image if given
+		bool offscreen = false;				// renders without showing a window
+		RendererBackend renderer = RENDERER_LEGACY;
+		int frameLimit = 0;					// stops after that many frames if positive
+	};
 
+	// headless runs draw every interval-th tick on the CPU into an image at path, with the tick
+	// number added before the extension
+	struct HeadlessRendering
+	{
+		char const *path = nullptr;
+		int interval = 0;
+	};
+
+	// false if the window or OpenGL context could not be created or the recording could not be written
+	bool run( RunSettings const &settings = RunSettings() );
+
+	// no window and no OpenGL, game and scene are stepped back to back as fast as possible
+	HeadlessStats runHeadless( int tickCount, float tickTime = SIM_TICK_TIME );
+	HeadlessStats runHeadlessFor( float duration, float tickTime = SIM_TICK_TIME );
+
+	// applies to headless runs and replays started afterwards
+	void setHeadlessRendering( HeadlessRendering const &rendering );
+
+	// headless run feeding a recorded input log back through the game, false if it cannot be read
+	bool runReplay( char const *path, HeadlessStats *stats );
+
+	// frame pacing, input handling and capture of the last run()
+	PacingStats getPacingStats();
+	InputStats getInputStats();
+	CaptureStats getCaptureStats();
+
+	// applies to runs started afterwards, windowed and headless
+	void setTimeStepPolicy( TimeStepPolicy const &policy );
+	TimeStepStats getTimeStepStats();
+
+	// the performance overlay on windowed runs and headless rendering, H toggles it in the window
+	void setHudVisible( bool visible );
+}
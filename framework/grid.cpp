@@ -0,0 +1,32 @@
+#include <cmath>
+#include <algorithm>
+
+#include "grid.hpp"
+
+
+namespace grid
+{
+	UniformGrid::UniformGrid( float width, float height, float cellSize ) :
+		halfWidth( 0.5f * width ),
+		halfHeight( 0.5f * height ),
+		cellSize( cellSize ),
+		columns( std::max( 1, ( int )std::ceil( width / cellSize ) ) ),
+		rows( std::max( 1, ( int )std::ceil( height / cellSize ) ) )
+	{
+		assert( width > 0.f && height > 0.f && cellSize > 0.f );
+	}
+
+
+	int UniformGrid::columnOf( float x ) const
+	{
+		int column = ( int )std::floor( ( x + halfWidth ) / cellSize );
+		return std::min( std::max( column, 0 ), columns - 1 );
+	}
+
+
+	int UniformGrid::rowOf( float y ) const
+	{
+		int row = ( int )std::floor( ( y + halfHeight ) / cellSize );
+		return std::min( std::max( row, 0 ), rows - 1 );
+	}
+}
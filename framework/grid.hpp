@@ -0,0 +1,95 @@
+#include <cassert>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	uniform grid spatial index
+//-------------------------------------------------------
+
+namespace grid
+{
+	// square cells over a rectangle centered on the origin; items are counting sorted by cell, so
+	// the items of a cell and of a row of neighbouring cells are contiguous, and positions outside
+	// the rectangle fall into the border cells
+	class UniformGrid
+	{
+	public:
+		UniformGrid( float width, float height, float cellSize );
+
+		int columnOf( float x ) const;
+		int rowOf( float y ) const;
+		int cellCount() const { return columns * rows; }
+
+		// reorders items into sorted by cell, positionOf( item, &x, &y ) gives an item's position
+		template< class Item, class PositionOf >
+		void sort( std::vector< Item > const &items, std::vector< Item > *sorted, PositionOf positionOf );
+
+		// visit( begin, end ) for the sorted items of each row of cells overlapping the rectangle,
+		// returns the number of cells covered
+		template< class Visit >
+		int query( float minX, float minY, float maxX, float maxY, Visit visit ) const;
+
+	private:
+		float const halfWidth;
+		float const halfHeight;
+		float const cellSize;
+		int const columns;
+		int const rows;
+
+		std::vector< int > cellStarts;		// first sorted item of each cell, plus the item count
+		std::vector< int > itemCells;		// scratch for sort()
+	};
+
+
+	//-------------------------------------------------------
+	template< class Item, class PositionOf >
+	void UniformGrid::sort( std::vector< Item > const &items, std::vector< Item > *sorted, PositionOf positionOf )
+	{
+		itemCells.resize( items.size() );
+		cellStarts.assign( cellCount() + 1, 0 );
+		for ( size_t i = 0; i < items.size(); ++i )
+		{
+			float x, y;
+			positionOf( items[ i ], &x, &y );
+			itemCells[ i ] = rowOf( y ) * columns + columnOf( x );
+			++cellStarts[ itemCells[ i ] + 1 ];
+		}
+		for ( int cell = 0; cell < cellCount(); ++cell )
+			cellStarts[ cell + 1 ] += cellStarts[ cell ];
+
+		// stable, items of a cell keep their order
+		sorted->resize( items.size() );
+		for ( size_t i = 0; i < items.size(); ++i )
+		{
+			int cell = itemCells[ i ];
+			( *sorted )[ cellStarts[ cell ] ] = items[ i ];
+			++cellStarts[ cell ];
+		}
+
+		// every start has moved on to the next cell's start, shift them back
+		for ( int cell = cellCount(); cell > 0; --cell )
+			cellStarts[ cell ] = cellStarts[ cell - 1 ];
+		cellStarts[ 0 ] = 0;
+	}
+
+
+	//-------------------------------------------------------
+	template< class Visit >
+	int UniformGrid::query( float minX, float minY, float maxX, float maxY, Visit visit ) const
+	{
+		assert( minX <= maxX && minY <= maxY );
+		if ( cellStarts.empty() )
+			return 0;
+
+		int firstColumn = columnOf( minX );
+		int lastColumn = columnOf( maxX );
+		for ( int row = rowOf( minY ); row <= rowOf( maxY ); ++row )
+		{
+			int begin = cellStarts[ row * columns + firstColumn ];
+			int end = cellStarts[ row * columns + lastColumn + 1 ];
+			if ( begin < end )
+				visit( begin, end );
+		}
+		return ( lastColumn - firstColumn + 1 ) * ( rowOf( maxY ) - rowOf( minY ) + 1 );
+	}
+}
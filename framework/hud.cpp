@@ -0,0 +1,151 @@
+#include <cstdio>
+#include <cstdarg>
+#include <algorithm>
+#include <vector>
+
+#include "hud.hpp"
+#include "render.hpp"
+#include "profiler.hpp"
+#include "platform.hpp"
+#include "memory.hpp"
+
+
+namespace
+{
+	constexpr float GLYPH_SCALE = 2.f;
+	constexpr float LINE_HEIGHT = render::GLYPH_HEIGHT * GLYPH_SCALE + 2.f;
+	constexpr float MARGIN = 8.f;
+
+	// two pixels per frame, the top of the graph is two 60 Hz frames
+	constexpr int GRAPH_FRAMES = 120;
+	constexpr float GRAPH_STEP = 2.f;
+	constexpr float GRAPH_HEIGHT = 64.f;
+	constexpr double GRAPH_MILLISECONDS = 1000.0 / 30.0;
+
+	render::Color const TEXT_COLOR = { 1.f, 1.f, 1.f };
+	render::Color const GRAPH_COLOR = { 0.3f, 1.f, 0.3f };
+	render::Color const FRAME_COLOR = { 0.6f, 0.6f, 0.6f };
+
+	// a line each, as of the last finished frame of their track
+	struct ShownPhase
+	{
+		profiler::Track track;
+		profiler::Phase phase;
+	};
+
+	ShownPhase const SHOWN_PHASES[] =
+	{
+		{ profiler::TRACK_RENDER, profiler::PHASE_SCENE_DRAW },
+		{ profiler::TRACK_RENDER, profiler::PHASE_EXECUTE_COMMANDS },
+		{ profiler::TRACK_RENDER, profiler::PHASE_SWAP_BUFFERS },
+		{ profiler::TRACK_SIMULATION, profiler::PHASE_GAME_UPDATE },
+		{ profiler::TRACK_SIMULATION, profiler::PHASE_SCENE_UPDATE },
+		{ profiler::TRACK_SIMULATION, profiler::PHASE_PUBLISH_SNAPSHOT },
+	};
+
+
+	bool visible = false;
+
+	// only touched by draw() on the render thread
+	long long lastFrameTicks = -1;
+	long long lastAllocationCount = 0;
+	double frameTimes[ GRAPH_FRAMES ] = {};		// milliseconds, a ring buffer
+	int nextFrame = 0;
+
+	// kept to reuse their storage, so the overlay itself allocates nothing once warmed up
+	std::vector< render::Glyph > glyphs;
+	std::vector< render::Vertex > graph;
+
+
+	void printLine( int line, char const *format, ... )
+	{
+		char text[ 96 ];
+		va_list arguments;
+		va_start( arguments, format );
+		std::vsnprintf( text, sizeof( text ), format, arguments );
+		va_end( arguments );
+
+		float x = MARGIN;
+		float y = MARGIN + line * LINE_HEIGHT;
+		for ( char const *character = text; *character; ++character, x += render::GLYPH_WIDTH * GLYPH_SCALE )
+			if ( *character != ' ' )
+				glyphs.push_back( render::Glyph{ x, y, *character, TEXT_COLOR } );
+	}
+
+
+	void addSegment( float x0, float y0, float x1, float y1, render::Color color )
+	{
+		graph.push_back( render::Vertex{ x0, y0, color.r, color.g, color.b } );
+		graph.push_back( render::Vertex{ x1, y1, color.r, color.g, color.b } );
+	}
+
+
+	void buildGraph( float top )
+	{
+		float left = MARGIN;
+		float right = left + ( GRAPH_FRAMES - 1 ) * GRAPH_STEP;
+		float bottom = top + GRAPH_HEIGHT;
+		addSegment( left, bottom, right, bottom, FRAME_COLOR );
+		addSegment( left, top, right, top, FRAME_COLOR );
+		addSegment( left, top + GRAPH_HEIGHT * 0.5f, right, top + GRAPH_HEIGHT * 0.5f, FRAME_COLOR );		// 60 Hz
+
+		// oldest frame on the left
+		auto heightOf = [ & ]( int age )
+		{
+			double time = frameTimes[ ( nextFrame + age ) % GRAPH_FRAMES ];
+			return bottom - ( float )( std::min( time / GRAPH_MILLISECONDS, 1.0 ) * GRAPH_HEIGHT );
+		};
+		for ( int age = 0; age + 1 < GRAPH_FRAMES; ++age )
+			addSegment( left + age * GRAPH_STEP, heightOf( age ), left + ( age + 1 ) * GRAPH_STEP, heightOf( age + 1 ), GRAPH_COLOR );
+	}
+}
+
+
+namespace hud
+{
+	void setVisible( bool show )
+	{
+		visible = show;
+	}
+
+
+	bool isVisible()
+	{
+		return visible;
+	}
+
+
+	void draw( render::CommandBuffer &commands, SceneCounts const &counts )
+	{
+		PROFILE_SCOPE( profiler::PHASE_DRAW_HUD );
+
+		long long now = platform::clockTicks();
+		long long allocationCount = memory::allocationCount();
+		long long allocations = lastFrameTicks >= 0 ? allocationCount - lastAllocationCount : 0;
+		lastAllocationCount = allocationCount;
+		if ( lastFrameTicks >= 0 )
+		{
+			frameTimes[ nextFrame ] = ( double )( now - lastFrameTicks ) * 1000.0 / ( double )platform::clockFrequency();
+			nextFrame = ( nextFrame + 1 ) % GRAPH_FRAMES;
+			profiler::addCount( profiler::COUNTER_ALLOCATIONS, allocations );
+		}
+		lastFrameTicks = now;
+		if ( !visible )
+			return;
+
+		double frameTime = frameTimes[ ( nextFrame + GRAPH_FRAMES - 1 ) % GRAPH_FRAMES ];
+		glyphs.clear();
+		printLine( 0, "FRAME %6.2f MS %5.0f FPS", frameTime, frameTime > 0.0 ? 1000.0 / frameTime : 0.0 );
+		printLine( 1, "MESHES %d/%d  PARTICLES %d/%d", counts.meshesDrawn, counts.meshes, counts.particlesDrawn, counts.particles );
+		printLine( 2, "ALLOCATIONS %lld PER FRAME", allocations );
+		int line = 3;
+		for ( ShownPhase const &shown : SHOWN_PHASES )
+			printLine( line++, "%-17s %6.2f MS", profiler::phaseName( shown.phase ), profiler::latestPhaseTime( shown.track, shown.phase ) );
+
+		graph.clear();
+		buildGraph( MARGIN + line * LINE_HEIGHT + 4.f );
+
+		commands.drawGlyphs( render::LAYER_HUD, glyphs.data(), ( int )glyphs.size(), GLYPH_SCALE );
+		commands.drawScreenLines( render::LAYER_HUD, graph.data(), ( int )graph.size() );
+	}
+}
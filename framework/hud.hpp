@@ -0,0 +1,28 @@
+namespace render
+{
+	class CommandBuffer;
+}
+
+
+//-------------------------------------------------------
+//	on-screen performance overlay
+//-------------------------------------------------------
+
+namespace hud
+{
+	// what scene::draw() had and drew this frame
+	struct SceneCounts
+	{
+		int meshes;
+		int meshesDrawn;
+		int particles;
+		int particlesDrawn;
+	};
+
+	void setVisible( bool visible );
+	bool isVisible();
+
+	// called once per drawn frame on the render thread, which times the frames for the graph even
+	// while hidden; the text goes in one glyph batch and the graph in one screen line batch
+	void draw( render::CommandBuffer &commands, SceneCounts const &counts );
+}
@@ -0,0 +1,290 @@
+#include <cassert>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+
+#include "jobs.hpp"
+
+
+//-------------------------------------------------------
+//	queues
+//-------------------------------------------------------
+
+namespace
+{
+	struct Task
+	{
+		jobs::Job job;
+		jobs::Counter *counter;
+	};
+
+
+	// the owner pushes and pops at the back, thieves take the oldest task from the front
+	struct Worker
+	{
+		std::thread thread;
+		std::mutex mutex;
+		std::deque< Task > tasks;
+	};
+
+
+	std::vector< std::unique_ptr< Worker > > workers;
+	std::atomic< bool > workersRunning( false );
+	thread_local int workerIndex = -1;
+
+	// tasks queued by threads outside of the pool
+	std::mutex injectedMutex;
+	std::deque< Task > injectedTasks;
+
+	// idle workers sleep until something gets queued
+	std::atomic< int > queuedTasks( 0 );
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+
+
+	//-------------------------------------------------------
+	void push( Task const &task )
+	{
+		if ( workerIndex >= 0 )
+		{
+			Worker &worker = *workers[ workerIndex ];
+			std::lock_guard< std::mutex > lock( worker.mutex );
+			worker.tasks.push_back( task );
+		}
+		else
+		{
+			std::lock_guard< std::mutex > lock( injectedMutex );
+			injectedTasks.push_back( task );
+		}
+
+		queuedTasks.fetch_add( 1 );
+		{
+			// a worker that found nothing either sees the new count or is already waiting
+			std::lock_guard< std::mutex > lock( sleepMutex );
+		}
+		wakeUp.notify_one();
+	}
+
+
+	//-------------------------------------------------------
+	bool popFront( std::mutex &mutex, std::deque< Task > &tasks, Task *task )
+	{
+		std::lock_guard< std::mutex > lock( mutex );
+		if ( tasks.empty() )
+			return false;
+		*task = tasks.front();
+		tasks.pop_front();
+		return true;
+	}
+
+
+	//-------------------------------------------------------
+	bool pop( Task *task )
+	{
+		bool found = false;
+		if ( workerIndex >= 0 )
+		{
+			Worker &worker = *workers[ workerIndex ];
+			std::lock_guard< std::mutex > lock( worker.mutex );
+			if ( !worker.tasks.empty() )
+			{
+				*task = worker.tasks.back();
+				worker.tasks.pop_back();
+				found = true;
+			}
+		}
+
+		found = found || popFront( injectedMutex, injectedTasks, task );
+
+		int workerCount = ( int )workers.size();
+		for ( int i = 1; !found && i <= workerCount; ++i )
+		{
+			Worker &victim = *workers[ ( std::max( workerIndex, 0 ) + i ) % workerCount ];
+			found = popFront( victim.mutex, victim.tasks, task );
+		}
+
+		if ( found )
+			queuedTasks.fetch_sub( 1 );
+		return found;
+	}
+}
+
+
+//-------------------------------------------------------
+//	counters
+//-------------------------------------------------------
+
+namespace jobs
+{
+	struct CounterAccess
+	{
+		static void raise( Counter &counter )
+		{
+			counter.pending.fetch_add( 1, std::memory_order_relaxed );
+		}
+
+
+		// the counter is only touched under its lock, wait() takes the same lock before returning
+		// so a counter on the waiter's stack outlives the last lower()
+		static void lower( Counter &counter )
+		{
+			std::vector< std::pair< Job, Counter* > > released;
+			{
+				std::lock_guard< std::mutex > lock( counter.continuationsMutex );
+				if ( counter.pending.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+					return;
+				released.swap( counter.continuations );
+			}
+			for ( auto const &continuation : released )
+				push( Task{ continuation.first, continuation.second } );
+		}
+
+
+		static void synchronize( Counter &counter )
+		{
+			std::lock_guard< std::mutex > lock( counter.continuationsMutex );
+		}
+
+
+		static void addContinuation( Counter &dependency, Job const &job, Counter *counter )
+		{
+			{
+				std::lock_guard< std::mutex > lock( dependency.continuationsMutex );
+				if ( !dependency.done() )
+				{
+					dependency.continuations.emplace_back( job, counter );
+					return;
+				}
+			}
+			push( Task{ job, counter } );
+		}
+	};
+}
+
+
+namespace
+{
+	//-------------------------------------------------------
+	void execute( Task const &task )
+	{
+		task.job.function( task.job.data, task.job.begin, task.job.end );
+		if ( task.counter )
+			jobs::CounterAccess::lower( *task.counter );
+	}
+
+
+	//-------------------------------------------------------
+	void workerLoop( int index )
+	{
+		workerIndex = index;
+		while ( true )
+		{
+			Task task;
+			if ( pop( &task ) )
+			{
+				execute( task );
+				continue;
+			}
+
+			std::unique_lock< std::mutex > lock( sleepMutex );
+			wakeUp.wait( lock, []() { return queuedTasks.load() > 0 || !workersRunning.load(); } );
+			if ( !workersRunning.load() )
+				break;
+		}
+		workerIndex = -1;
+	}
+}
+
+
+//-------------------------------------------------------
+//	public interface
+//-------------------------------------------------------
+
+namespace jobs
+{
+	void init( int workerCount )
+	{
+		assert( workers.empty() );
+		if ( workerCount < 0 )
+			workerCount = std::max( ( int )std::thread::hardware_concurrency() - 1, 0 );
+
+		// every deque exists before the first worker may try to steal from it
+		for ( int i = 0; i < workerCount; ++i )
+			workers.emplace_back( new Worker );
+		workersRunning.store( true );
+		for ( int i = 0; i < workerCount; ++i )
+			workers[ i ]->thread = std::thread( workerLoop, i );
+	}
+
+
+	void deinit()
+	{
+		{
+			std::lock_guard< std::mutex > lock( sleepMutex );
+			workersRunning.store( false );
+		}
+		wakeUp.notify_all();
+		for ( std::unique_ptr< Worker > &worker : workers )
+			worker->thread.join();
+		workers.clear();
+		assert( queuedTasks.load() == 0 );
+	}
+
+
+	int workerCount()
+	{
+		return ( int )workers.size();
+	}
+
+
+	void run( Job const &job, Counter *counter )
+	{
+		if ( counter )
+			CounterAccess::raise( *counter );
+		push( Task{ job, counter } );
+	}
+
+
+	void runAfter( Counter &dependency, Job const &job, Counter *counter )
+	{
+		if ( counter )
+			CounterAccess::raise( *counter );
+		CounterAccess::addContinuation( dependency, job, counter );
+	}
+
+
+	void wait( Counter &counter )
+	{
+		while ( !counter.done() )
+		{
+			Task task;
+			if ( pop( &task ) )
+				execute( task );
+			else
+				std::this_thread::yield();
+		}
+		CounterAccess::synchronize( counter );
+	}
+
+
+	void parallelFor( int count, int grainSize, Function function, void const *data )
+	{
+		assert( grainSize > 0 );
+		if ( count <= grainSize || workers.empty() )
+		{
+			for ( int begin = 0; begin < count; begin += grainSize )
+				function( data, begin, std::min( begin + grainSize, count ) );
+			return;
+		}
+
+		Counter counter;
+		for ( int begin = grainSize; begin < count; begin += grainSize )
+			run( Job{ function, data, begin, std::min( begin + grainSize, count ) }, &counter );
+
+		// the first chunk runs here, the rest is picked up by workers or helped with while waiting
+		function( data, 0, grainSize );
+		wait( counter );
+	}
+}
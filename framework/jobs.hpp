@@ -0,0 +1,64 @@
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+
+namespace jobs
+{
+	typedef void ( *Function )( void const *data, int begin, int end );
+
+	struct Job
+	{
+		Function function;
+		void const *data;		// owned by the caller, must outlive the job
+		int begin;
+		int end;
+	};
+
+
+	// counts unfinished jobs; jobs queued with runAfter() start once it drops to zero
+	class Counter
+	{
+	public:
+		Counter() = default;
+		Counter( Counter const & ) = delete;
+		Counter &operator = ( Counter const & ) = delete;
+
+		bool done() const { return pending.load( std::memory_order_acquire ) == 0; }
+
+	private:
+		friend struct CounterAccess;
+
+		std::atomic< int > pending{ 0 };
+		std::mutex continuationsMutex;
+		std::vector< std::pair< Job, Counter* > > continuations;
+	};
+
+
+	// workerCount < 0 starts one worker per core beyond the calling thread, 0 runs everything on waiting threads
+	void init( int workerCount = -1 );
+	void deinit();
+	int workerCount();
+
+	// counter, if given, is raised right away and lowered once the job has finished
+	void run( Job const &job, Counter *counter = nullptr );
+	void runAfter( Counter &dependency, Job const &job, Counter *counter = nullptr );
+
+	// runs queued jobs on the calling thread until the counter drops to zero
+	void wait( Counter &counter );
+
+	// splits [0, count) into grainSize chunks and returns once all of them ran; chunk boundaries
+	// do not depend on the worker count, so per-chunk results can be merged deterministically
+	void parallelFor( int count, int grainSize, Function function, void const *data );
+
+
+	template< class Body >
+	void parallelFor( int count, int grainSize, Body const &body )
+	{
+		Function function = []( void const *data, int begin, int end )
+		{
+			( *static_cast< Body const* >( data ) )( begin, end );
+		};
+		parallelFor( count, grainSize, function, &body );
+	}
+}
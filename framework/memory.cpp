@@ -0,0 +1,93 @@
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+#include "memory.hpp"
+
+
+namespace
+{
+	std::atomic< long long > allocations( 0 );
+
+
+	void *allocate( std::size_t size )
+	{
+		allocations.fetch_add( 1, std::memory_order_relaxed );
+		return std::malloc( size ? size : 1 );
+	}
+}
+
+
+namespace memory
+{
+	long long allocationCount()
+	{
+		return allocations.load( std::memory_order_relaxed );
+	}
+}
+
+
+//-------------------------------------------------------
+//	global operator new and delete, replaced to count
+//-------------------------------------------------------
+
+void *operator new( std::size_t size )
+{
+	if ( void *memory = allocate( size ) )
+		return memory;
+	throw std::bad_alloc();
+}
+
+
+void *operator new[]( std::size_t size )
+{
+	return operator new( size );
+}
+
+
+void *operator new( std::size_t size, std::nothrow_t const & ) noexcept
+{
+	return allocate( size );
+}
+
+
+void *operator new[]( std::size_t size, std::nothrow_t const & ) noexcept
+{
+	return allocate( size );
+}
+
+
+void operator delete( void *memory ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete[]( void *memory ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete( void *memory, std::size_t ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete[]( void *memory, std::size_t ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete( void *memory, std::nothrow_t const & ) noexcept
+{
+	std::free( memory );
+}
+
+
+void operator delete[]( void *memory, std::nothrow_t const & ) noexcept
+{
+	std::free( memory );
+}
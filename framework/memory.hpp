@@ -0,0 +1,106 @@
+#include <cassert>
+#include <memory>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	heap allocation counting
+//-------------------------------------------------------
+
+namespace memory
+{
+	// every operator new on any thread since start up; relaxed, so a count read on one thread may
+	// miss allocations just made on another
+	long long allocationCount();
+}
+
+
+//-------------------------------------------------------
+//	fixed block pools
+//-------------------------------------------------------
+
+namespace memory
+{
+	// storage for objects of one type in fixed size blocks, taken from the heap a chunk at a time
+	// and only given back when the pool goes away; a freed block is the next one handed out.
+	// Not thread safe, blocks hold no object until the caller constructs one in place
+	template< class Object, int CHUNK_BLOCKS = 64 >
+	class Pool
+	{
+	public:
+		Pool() = default;
+		Pool( Pool const & ) = delete;
+		Pool &operator = ( Pool const & ) = delete;
+
+		void *allocate();
+		void free( void *block );
+
+		// one chunk for what is missing to hand out that many blocks without touching the heap
+		void reserve( int count );
+
+		int capacity() const { return blockCount; }
+		int chunkCount() const { return ( int )chunks.size(); }
+
+	private:
+		union Block
+		{
+			Block *next;
+			alignas( Object ) unsigned char storage[ sizeof( Object ) ];
+		};
+
+		void addChunk( int blocks );
+
+		std::vector< std::unique_ptr< Block[] > > chunks;
+		Block *firstFree = nullptr;
+		int blockCount = 0;
+		int blocksInUse = 0;
+	};
+
+
+	//-------------------------------------------------------
+	template< class Object, int CHUNK_BLOCKS >
+	void *Pool< Object, CHUNK_BLOCKS >::allocate()
+	{
+		if ( !firstFree )
+			addChunk( CHUNK_BLOCKS );
+
+		Block *block = firstFree;
+		firstFree = block->next;
+		++blocksInUse;
+		return block->storage;
+	}
+
+
+	//-------------------------------------------------------
+	template< class Object, int CHUNK_BLOCKS >
+	void Pool< Object, CHUNK_BLOCKS >::free( void *storage )
+	{
+		assert( blocksInUse > 0 );
+		Block *block = reinterpret_cast< Block* >( storage );
+		block->next = firstFree;
+		firstFree = block;
+		--blocksInUse;
+	}
+
+
+	//-------------------------------------------------------
+	template< class Object, int CHUNK_BLOCKS >
+	void Pool< Object, CHUNK_BLOCKS >::reserve( int count )
+	{
+		if ( count > blockCount - blocksInUse )
+			addChunk( count - ( blockCount - blocksInUse ) );
+	}
+
+
+	//-------------------------------------------------------
+	template< class Object, int CHUNK_BLOCKS >
+	void Pool< Object, CHUNK_BLOCKS >::addChunk( int blocks )
+	{
+		std::unique_ptr< Block[] > chunk( new Block[ blocks ] );
+		for ( int i = 0; i < blocks; ++i )
+			chunk[ i ].next = i + 1 < blocks ? &chunk[ i + 1 ] : firstFree;
+		firstFree = &chunk[ 0 ];
+		chunks.push_back( std::move( chunk ) );
+		blockCount += blocks;
+	}
+}
@@ -0,0 +1,366 @@
+#include <cassert>
+#include <array>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "opengl.hpp"
+#include "platform.hpp"
+#include "render.hpp"
+
+
+namespace gl
+{
+	#define OPENGL_DEFINE_FUNCTION( result, name, parameters ) \
+		name##Function name = nullptr;
+
+	OPENGL_FUNCTIONS( OPENGL_DEFINE_FUNCTION )
+	OPENGL_CORE_FUNCTIONS( OPENGL_DEFINE_FUNCTION )
+
+	#undef OPENGL_DEFINE_FUNCTION
+
+
+	namespace
+	{
+		// core name first, then the ARB extension name older drivers only expose
+		template< class Function >
+		bool loadFunction( Function *function, char const *name )
+		{
+			std::string coreName = std::string( "gl" ) + name;
+			*function = reinterpret_cast< Function >( platform::getProcAddress( coreName.c_str() ) );
+			if ( !*function )
+				*function = reinterpret_cast< Function >( platform::getProcAddress( ( coreName + "ARB" ).c_str() ) );
+			return *function != nullptr;
+		}
+	}
+
+
+	bool loadFunctions()
+	{
+		bool loaded = true;
+
+		#define OPENGL_LOAD_FUNCTION( result, name, parameters ) \
+			loaded = loadFunction( &name, #name ) && loaded;
+
+		OPENGL_FUNCTIONS( OPENGL_LOAD_FUNCTION )
+
+		#undef OPENGL_LOAD_FUNCTION
+
+		return loaded;
+	}
+
+
+	bool loadCoreFunctions()
+	{
+		bool loaded = loadFunctions();
+
+		#define OPENGL_LOAD_FUNCTION( result, name, parameters ) \
+			loaded = loadFunction( &name, #name ) && loaded;
+
+		OPENGL_CORE_FUNCTIONS( OPENGL_LOAD_FUNCTION )
+
+		#undef OPENGL_LOAD_FUNCTION
+
+		return loaded;
+	}
+}
+
+
+//-------------------------------------------------------
+//	state cache
+//-------------------------------------------------------
+
+namespace gl
+{
+	void StateCache::invalidate()
+	{
+		currentMatrixMode.known = false;
+		for ( Tracked< float > &component : viewRectangle )
+			component.known = false;
+		isModelviewIdentity.known = false;
+		capabilityCount = 0;
+		for ( Tracked< float > &component : clearColors )
+			component.known = false;
+		currentLineWidth.known = false;
+		currentPointSize.known = false;
+		vertexArray.known = colorArray.known = textureCoordArray.known = false;
+		texture.known = false;
+		arrayBuffer.known = false;
+		vertexArrayObject.known = false;
+		program.known = false;
+		for ( int i = 0; i < MAX_ATTRIBUTES; ++i )
+			attributeArrays[ i ].known = attributeDivisors[ i ].known = false;
+		changes = 0;
+		filtered = 0;
+	}
+
+
+	template< class Value >
+	bool StateCache::change( Tracked< Value > &tracked, Value value )
+	{
+		if ( tracked.known && tracked.value == value )
+		{
+			++filtered;
+			return false;
+		}
+		tracked.known = true;
+		tracked.value = value;
+		++changes;
+		return true;
+	}
+
+
+	bool StateCache::changeAll( Tracked< float > ( &tracked )[ 4 ], std::array< float, 4 > const &values )
+	{
+		bool same = true;
+		for ( int i = 0; i < 4; ++i )
+			same = same && tracked[ i ].known && tracked[ i ].value == values[ i ];
+		if ( same )
+		{
+			++filtered;
+			return false;
+		}
+		for ( int i = 0; i < 4; ++i )
+			tracked[ i ] = { true, values[ i ] };
+		++changes;
+		return true;
+	}
+
+
+	void StateCache::matrixMode( GLenum mode )
+	{
+		if ( change( currentMatrixMode, mode ) )
+			glMatrixMode( mode );
+	}
+
+
+	void StateCache::view( float centerX, float centerY, float width, float height )
+	{
+		// one change, the whole projection is loaded again
+		if ( !changeAll( viewRectangle, { centerX, centerY, width, height } ) )
+			return;
+		matrixMode( GL_PROJECTION );
+		glLoadIdentity();
+		glScalef( 2.f / width, 2.f / height, 0.f );
+		glTranslatef( -centerX, -centerY, 0.f );
+	}
+
+
+	void StateCache::modelviewIdentity()
+	{
+		matrixMode( GL_MODELVIEW );
+		if ( change( isModelviewIdentity, true ) )
+			glLoadIdentity();
+	}
+
+
+	void StateCache::modelviewChanged()
+	{
+		isModelviewIdentity = { true, false };
+	}
+
+
+	void StateCache::capability( GLenum name, bool enabled )
+	{
+		int index = 0;
+		while ( index < capabilityCount && capabilityNames[ index ] != name )
+			++index;
+		if ( index == capabilityCount )
+		{
+			assert( capabilityCount < MAX_CAPABILITIES );
+			capabilityNames[ capabilityCount ] = name;
+			capabilities[ capabilityCount++ ].known = false;
+		}
+
+		if ( !change( capabilities[ index ], enabled ) )
+			return;
+		if ( enabled )
+			glEnable( name );
+		else
+			glDisable( name );
+	}
+
+
+	void StateCache::clearColor( float r, float g, float b, float a )
+	{
+		if ( changeAll( clearColors, { r, g, b, a } ) )
+			glClearColor( r, g, b, a );
+	}
+
+
+	void StateCache::lineWidth( float width )
+	{
+		if ( change( currentLineWidth, width ) )
+			glLineWidth( width );
+	}
+
+
+	void StateCache::pointSize( float size )
+	{
+		if ( change( currentPointSize, size ) )
+			glPointSize( size );
+	}
+
+
+	void StateCache::clientState( GLenum array, bool enabled )
+	{
+		assert( array == GL_VERTEX_ARRAY || array == GL_COLOR_ARRAY || array == GL_TEXTURE_COORD_ARRAY );
+		Tracked< bool > &tracked = array == GL_VERTEX_ARRAY ? vertexArray : array == GL_COLOR_ARRAY ? colorArray : textureCoordArray;
+		if ( !change( tracked, enabled ) )
+			return;
+		if ( enabled )
+			glEnableClientState( array );
+		else
+			glDisableClientState( array );
+	}
+
+
+	void StateCache::bindTexture( GLuint name )
+	{
+		if ( change( texture, name ) )
+			glBindTexture( GL_TEXTURE_2D, name );
+	}
+
+
+	void StateCache::bindArrayBuffer( GLuint buffer )
+	{
+		if ( change( arrayBuffer, buffer ) )
+			BindBuffer( GL_ARRAY_BUFFER, buffer );
+	}
+
+
+	void StateCache::bindVertexArray( GLuint array )
+	{
+		if ( change( vertexArrayObject, array ) )
+			BindVertexArray( array );
+	}
+
+
+	void StateCache::useProgram( GLuint name )
+	{
+		if ( change( program, name ) )
+			UseProgram( name );
+	}
+
+
+	void StateCache::vertexAttribArray( GLuint index, bool enabled )
+	{
+		assert( index < MAX_ATTRIBUTES );
+		if ( !change( attributeArrays[ index ], enabled ) )
+			return;
+		if ( enabled )
+			EnableVertexAttribArray( index );
+		else
+			DisableVertexAttribArray( index );
+	}
+
+
+	void StateCache::vertexAttribDivisor( GLuint index, GLuint divisor )
+	{
+		assert( index < MAX_ATTRIBUTES );
+		if ( change( attributeDivisors[ index ], divisor ) )
+			VertexAttribDivisor( index, divisor );
+	}
+
+
+	void StateCache::takeCounts( int *changesMade, int *changesFiltered )
+	{
+		*changesMade = changes;
+		*changesFiltered = filtered;
+		changes = 0;
+		filtered = 0;
+	}
+}
+
+
+//-------------------------------------------------------
+//	frame read back
+//-------------------------------------------------------
+
+namespace gl
+{
+	FrameReader::FrameReader()
+	{
+		for ( Buffer &buffer : buffers )
+			GenBuffers( 1, &buffer.buffer );
+	}
+
+
+	FrameReader::~FrameReader()
+	{
+		for ( Buffer &buffer : buffers )
+			DeleteBuffers( 1, &buffer.buffer );
+	}
+
+
+	void FrameReader::readFrame( render::Image *image )
+	{
+		GLint viewport[ 4 ];
+		glGetIntegerv( GL_VIEWPORT, viewport );
+		image->width = viewport[ 2 ];
+		image->height = viewport[ 3 ];
+		image->pixels.resize( ( size_t )image->width * image->height * 3 );
+
+		// OpenGL rows go bottom to top
+		std::vector< unsigned char > rows( image->pixels.size() );
+		glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+		glReadPixels( viewport[ 0 ], viewport[ 1 ], image->width, image->height, GL_RGB, GL_UNSIGNED_BYTE, rows.data() );
+		size_t rowSize = ( size_t )image->width * 3;
+		for ( int y = 0; y < image->height; ++y )
+			std::copy( rows.begin() + y * rowSize, rows.begin() + ( y + 1 ) * rowSize, image->pixels.begin() + ( image->height - 1 - y ) * rowSize );
+	}
+
+
+	// the pixels of a pending capture, flipped to rows top to bottom
+	bool FrameReader::mapCapture( int index, render::Image *image )
+	{
+		Buffer &capture = buffers[ index ];
+		if ( !capture.pending )
+			return false;
+		capture.pending = false;
+
+		BindBuffer( GL_PIXEL_PACK_BUFFER, capture.buffer );
+		unsigned char const *rows = static_cast< unsigned char const* >( MapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY ) );
+		if ( rows )
+		{
+			image->width = capture.width;
+			image->height = capture.height;
+			image->pixels.resize( ( size_t )capture.width * capture.height * 3 );
+			size_t rowSize = ( size_t )capture.width * 3;
+			for ( int y = 0; y < capture.height; ++y )
+				std::copy( rows + y * rowSize, rows + ( y + 1 ) * rowSize, image->pixels.begin() + ( capture.height - 1 - y ) * rowSize );
+			UnmapBuffer( GL_PIXEL_PACK_BUFFER );
+		}
+		BindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+		return rows != nullptr;
+	}
+
+
+	bool FrameReader::captureFrame( render::Image *image )
+	{
+		// glReadPixels into a bound pack buffer returns at once, the copy runs on the GPU
+		Buffer &capture = buffers[ next ];
+		GLint viewport[ 4 ];
+		glGetIntegerv( GL_VIEWPORT, viewport );
+		capture.width = viewport[ 2 ];
+		capture.height = viewport[ 3 ];
+		capture.pending = true;
+		BindBuffer( GL_PIXEL_PACK_BUFFER, capture.buffer );
+		BufferData( GL_PIXEL_PACK_BUFFER, ( std::ptrdiff_t )capture.width * capture.height * 3, nullptr, GL_STREAM_READ );
+		glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+		glReadPixels( viewport[ 0 ], viewport[ 1 ], capture.width, capture.height, GL_RGB, GL_UNSIGNED_BYTE, nullptr );
+		BindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+		next ^= 1;
+		return mapCapture( next, image );
+	}
+
+
+	bool FrameReader::finishCapture( render::Image *image )
+	{
+		// the older one first
+		if ( mapCapture( next, image ) )
+			return true;
+		return mapCapture( next ^ 1, image );
+	}
+}
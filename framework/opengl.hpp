@@ -0,0 +1,211 @@
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <cstddef>
+#include <array>
+
+
+namespace render
+{
+	struct Image;
+}
+
+
+//-------------------------------------------------------
+//	functions beyond OpenGL 1.1, loaded at runtime
+//-------------------------------------------------------
+
+// the Windows SDK stops at OpenGL 1.1, so the few constants in use are defined here
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER					0x8892
+#define GL_STATIC_DRAW					0x88E4
+#define GL_STREAM_DRAW					0x88E0
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER			0x88EB
+#define GL_STREAM_READ					0x88E1
+#define GL_READ_ONLY					0x88B8
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER				0x8B30
+#define GL_VERTEX_SHADER				0x8B31
+#define GL_COMPILE_STATUS				0x8B81
+#define GL_LINK_STATUS					0x8B82
+#endif
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER				0x8A11
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT	0x8A34
+#define GL_INVALID_INDEX				0xFFFFFFFFu
+#endif
+#ifndef GL_R8
+#define GL_R8							0x8229
+#endif
+
+#define OPENGL_FUNCTIONS( FUNCTION ) \
+	FUNCTION( void, GenBuffers, ( GLsizei count, GLuint *buffers ) ) \
+	FUNCTION( void, DeleteBuffers, ( GLsizei count, GLuint const *buffers ) ) \
+	FUNCTION( void, BindBuffer, ( GLenum target, GLuint buffer ) ) \
+	FUNCTION( void, BufferData, ( GLenum target, std::ptrdiff_t size, void const *data, GLenum usage ) ) \
+	FUNCTION( void*, MapBuffer, ( GLenum target, GLenum access ) ) \
+	FUNCTION( GLboolean, UnmapBuffer, ( GLenum target ) ) \
+	FUNCTION( GLuint, CreateShader, ( GLenum type ) ) \
+	FUNCTION( void, DeleteShader, ( GLuint shader ) ) \
+	FUNCTION( void, ShaderSource, ( GLuint shader, GLsizei count, char const *const *sources, GLint const *lengths ) ) \
+	FUNCTION( void, CompileShader, ( GLuint shader ) ) \
+	FUNCTION( void, GetShaderiv, ( GLuint shader, GLenum name, GLint *value ) ) \
+	FUNCTION( GLuint, CreateProgram, () ) \
+	FUNCTION( void, DeleteProgram, ( GLuint program ) ) \
+	FUNCTION( void, AttachShader, ( GLuint program, GLuint shader ) ) \
+	FUNCTION( void, BindAttribLocation, ( GLuint program, GLuint index, char const *name ) ) \
+	FUNCTION( void, LinkProgram, ( GLuint program ) ) \
+	FUNCTION( void, GetProgramiv, ( GLuint program, GLenum name, GLint *value ) ) \
+	FUNCTION( void, UseProgram, ( GLuint program ) ) \
+	FUNCTION( void, EnableVertexAttribArray, ( GLuint index ) ) \
+	FUNCTION( void, DisableVertexAttribArray, ( GLuint index ) ) \
+	FUNCTION( void, VertexAttribPointer, ( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, void const *offset ) ) \
+	FUNCTION( void, VertexAttribDivisor, ( GLuint index, GLuint divisor ) ) \
+	FUNCTION( void, DrawArraysInstanced, ( GLenum mode, GLint first, GLsizei count, GLsizei instanceCount ) )
+
+// the rest of what an OpenGL 3.3 core context needs: vertex array objects and uniform buffers
+#define OPENGL_CORE_FUNCTIONS( FUNCTION ) \
+	FUNCTION( void, GenVertexArrays, ( GLsizei count, GLuint *arrays ) ) \
+	FUNCTION( void, DeleteVertexArrays, ( GLsizei count, GLuint const *arrays ) ) \
+	FUNCTION( void, BindVertexArray, ( GLuint array ) ) \
+	FUNCTION( void, BufferSubData, ( GLenum target, std::ptrdiff_t offset, std::ptrdiff_t size, void const *data ) ) \
+	FUNCTION( void, BindBufferRange, ( GLenum target, GLuint index, GLuint buffer, std::ptrdiff_t offset, std::ptrdiff_t size ) ) \
+	FUNCTION( GLuint, GetUniformBlockIndex, ( GLuint program, char const *name ) ) \
+	FUNCTION( void, UniformBlockBinding, ( GLuint program, GLuint blockIndex, GLuint binding ) )
+
+
+namespace gl
+{
+	#define OPENGL_DECLARE_FUNCTION( result, name, parameters ) \
+		typedef result ( APIENTRY *name##Function ) parameters; \
+		extern name##Function name;
+
+	OPENGL_FUNCTIONS( OPENGL_DECLARE_FUNCTION )
+	OPENGL_CORE_FUNCTIONS( OPENGL_DECLARE_FUNCTION )
+
+	#undef OPENGL_DECLARE_FUNCTION
+
+	// need a current context, false if any of the OPENGL_FUNCTIONS, or for the core ones
+	// any of both lists, is missing
+	bool loadFunctions();
+	bool loadCoreFunctions();
+}
+
+
+//-------------------------------------------------------
+//	state cache
+//-------------------------------------------------------
+
+namespace gl
+{
+	// shadows the state the renderers set and drops changes to the value already set; knows nothing
+	// until the first change of each kind, so state left by others must be reported with invalidate()
+	class StateCache
+	{
+	public:
+		StateCache() { invalidate(); }
+
+		void invalidate();
+
+		void matrixMode( GLenum mode );
+		void view( float centerX, float centerY, float width, float height );		// projection showing that world rectangle
+		void modelviewIdentity();
+		void modelviewChanged();				// after transforming the modelview matrix directly
+
+		void capability( GLenum capability, bool enabled );
+		void clearColor( float r, float g, float b, float a );
+		void lineWidth( float width );
+		void pointSize( float size );
+		void clientState( GLenum array, bool enabled );		// GL_VERTEX_ARRAY, GL_COLOR_ARRAY or GL_TEXTURE_COORD_ARRAY
+		void bindTexture( GLuint texture );					// to GL_TEXTURE_2D
+
+		void bindArrayBuffer( GLuint buffer );
+		void bindVertexArray( GLuint array );			// core contexts only
+		void useProgram( GLuint program );
+		void vertexAttribArray( GLuint index, bool enabled );
+		void vertexAttribDivisor( GLuint index, GLuint divisor );
+
+		// state changes made and filtered out since the last call
+		void takeCounts( int *changes, int *filtered );
+
+	private:
+		template< class Value >
+		struct Tracked
+		{
+			bool known;
+			Value value;
+		};
+
+		template< class Value >
+		bool change( Tracked< Value > &tracked, Value value );
+		bool changeAll( Tracked< float > ( &tracked )[ 4 ], std::array< float, 4 > const &values );		// counted as one change
+
+		static constexpr int MAX_CAPABILITIES = 4;
+		static constexpr int MAX_ATTRIBUTES = 8;
+
+		Tracked< GLenum > currentMatrixMode;
+		Tracked< float > viewRectangle[ 4 ];
+		Tracked< bool > isModelviewIdentity;
+		GLenum capabilityNames[ MAX_CAPABILITIES ];
+		Tracked< bool > capabilities[ MAX_CAPABILITIES ];
+		int capabilityCount;
+		Tracked< float > clearColors[ 4 ];
+		Tracked< float > currentLineWidth;
+		Tracked< float > currentPointSize;
+		Tracked< bool > vertexArray, colorArray, textureCoordArray;
+		Tracked< GLuint > texture;
+		Tracked< GLuint > arrayBuffer;
+		Tracked< GLuint > vertexArrayObject;
+		Tracked< GLuint > program;
+		Tracked< bool > attributeArrays[ MAX_ATTRIBUTES ];
+		Tracked< GLuint > attributeDivisors[ MAX_ATTRIBUTES ];
+
+		int changes;
+		int filtered;
+	};
+}
+
+
+//-------------------------------------------------------
+//	frame read back
+//-------------------------------------------------------
+
+namespace gl
+{
+	// frames are read back into one pixel pack buffer while the other one, filled a frame earlier
+	// and long finished by the GPU, is copied out; needs the buffer functions
+	class FrameReader
+	{
+	public:
+		FrameReader();
+		~FrameReader();
+
+		FrameReader( FrameReader const & ) = delete;
+		FrameReader &operator = ( FrameReader const & ) = delete;
+
+		// the viewport, waiting for the GPU to finish drawing it
+		static void readFrame( render::Image *image );
+
+		// as render::Renderer::captureFrame() and finishCapture()
+		bool captureFrame( render::Image *image );
+		bool finishCapture( render::Image *image );
+
+	private:
+		struct Buffer
+		{
+			GLuint buffer;
+			int width;
+			int height;
+			bool pending;
+		};
+
+		bool mapCapture( int index, render::Image *image );
+
+		Buffer buffers[ 2 ] = {};
+		int next = 0;
+	};
+}
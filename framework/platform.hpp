@@ -0,0 +1,81 @@
+
+
+//-------------------------------------------------------
+//	clock
+//-------------------------------------------------------
+
+namespace platform
+{
+	long long clockTicks();
+	long long clockFrequency();		// ticks per second
+
+	// coarse sleep, used by pacing code that spins for the remainder
+	void sleepMilliseconds( int milliseconds );
+
+	// raises the scheduler resolution for sleepMilliseconds() where the OS needs it
+	void beginFinePacing();
+	void endFinePacing();
+}
+
+
+//-------------------------------------------------------
+//	window and OpenGL context
+//-------------------------------------------------------
+
+namespace platform
+{
+	enum Key
+	{
+		KEY_UNKNOWN,
+		KEY_W,
+		KEY_A,
+		KEY_S,
+		KEY_D,
+		KEY_I,
+		KEY_J,
+		KEY_K,
+		KEY_L,
+		KEY_U,
+		KEY_O,
+		KEY_H,
+		KEY_UP,
+		KEY_DOWN,
+		KEY_LEFT,
+		KEY_RIGHT,
+		KEY_SPACE,
+		KEY_ESCAPE
+	};
+
+	// called from processWindowMessages() on the thread that created the window,
+	// mouse coordinates are normalized to [0, 1] with y pointing up
+	struct WindowListener
+	{
+		void ( *keyPressed )( Key key, bool isRepeat );
+		void ( *keyReleased )( Key key );
+		void ( *mouseClicked )( float x, float y, bool isLeftButton );
+	};
+
+	// an offscreen window is never shown: a hidden window on Windows, an EGL surfaceless
+	// context rendering into a framebuffer object on Linux, which works without X and GPU
+	bool initWindow( int width, int height, char const *title, WindowListener const &listener, bool offscreen );
+	void deinitWindow();
+	void closeWindow();
+
+	// false once the window has been closed
+	bool processWindowMessages();
+
+	// the compatibility context keeps the fixed function pipeline, the core one is OpenGL 3.3
+	// without it; false if the driver cannot create the one asked for
+	enum ContextProfile
+	{
+		CONTEXT_COMPATIBILITY,
+		CONTEXT_CORE,
+	};
+
+	bool initOGL( ContextProfile profile );
+	void deinitOGL();
+	void swapBuffers();
+
+	// OpenGL entry points beyond 1.1, null if the driver does not have them
+	void *getProcAddress( char const *name );
+}
@@ -0,0 +1,427 @@
+#ifndef _WIN32
+
+#include <cassert>
+#include <ctime>
+#include <cerrno>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/XKBlib.h>
+#include <X11/keysym.h>
+#include <GL/glx.h>
+#include <GL/glext.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "platform.hpp"
+
+
+//-------------------------------------------------------
+//	clock
+//-------------------------------------------------------
+
+namespace platform
+{
+	long long clockTicks()
+	{
+		timespec now;
+		clock_gettime( CLOCK_MONOTONIC, &now );
+		return ( long long )now.tv_sec * 1000000000LL + now.tv_nsec;
+	}
+
+
+	long long clockFrequency()
+	{
+		return 1000000000LL;
+	}
+
+
+	void sleepMilliseconds( int milliseconds )
+	{
+		timespec duration;
+		duration.tv_sec = milliseconds / 1000;
+		duration.tv_nsec = ( long )( milliseconds % 1000 ) * 1000000L;
+		while ( nanosleep( &duration, &duration ) != 0 && errno == EINTR )
+		{
+		}
+	}
+
+
+	// the Linux scheduler already sleeps with sub-millisecond precision
+	void beginFinePacing()
+	{
+	}
+
+
+	void endFinePacing()
+	{
+	}
+}
+
+
+//-------------------------------------------------------
+//	window related stuff
+//-------------------------------------------------------
+
+namespace
+{
+	Display *display = nullptr;
+	Window window = 0;
+	Colormap colormap = 0;
+	XVisualInfo *visualInfo = nullptr;
+	Atom deleteWindowAtom = 0;
+	platform::WindowListener windowListener;
+	int windowWidth = 0;
+	int windowHeight = 0;
+	bool windowOpen = false;
+	bool offscreenWindow = false;
+
+
+	//-------------------------------------------------------
+	platform::Key toKey( KeySym keySym )
+	{
+		switch ( keySym )
+		{
+			case XK_w:		return platform::KEY_W;
+			case XK_a:		return platform::KEY_A;
+			case XK_s:		return platform::KEY_S;
+			case XK_d:		return platform::KEY_D;
+			case XK_i:		return platform::KEY_I;
+			case XK_j:		return platform::KEY_J;
+			case XK_k:		return platform::KEY_K;
+			case XK_l:		return platform::KEY_L;
+			case XK_u:		return platform::KEY_U;
+			case XK_o:		return platform::KEY_O;
+			case XK_h:		return platform::KEY_H;
+			case XK_Up:		return platform::KEY_UP;
+			case XK_Down:	return platform::KEY_DOWN;
+			case XK_Left:	return platform::KEY_LEFT;
+			case XK_Right:	return platform::KEY_RIGHT;
+			case XK_space:	return platform::KEY_SPACE;
+			case XK_Escape:	return platform::KEY_ESCAPE;
+			default:		return platform::KEY_UNKNOWN;
+		}
+	}
+
+
+	//-------------------------------------------------------
+	bool keyDown[ 256 ];
+
+
+	//-------------------------------------------------------
+	void handleEvent( XEvent &event )
+	{
+		switch ( event.type )
+		{
+			case ClientMessage:
+				if ( ( Atom )event.xclient.data.l[ 0 ] == deleteWindowAtom )
+					windowOpen = false;
+				break;
+
+			case KeyPress:
+			{
+				// with detectable auto-repeat, a repeat is a press without a release in between
+				unsigned keyCode = event.xkey.keycode & 0xff;
+				bool isRepeat = keyDown[ keyCode ];
+				keyDown[ keyCode ] = true;
+				windowListener.keyPressed( toKey( XLookupKeysym( &event.xkey, 0 ) ), isRepeat );
+				break;
+			}
+
+			case KeyRelease:
+				keyDown[ event.xkey.keycode & 0xff ] = false;
+				windowListener.keyReleased( toKey( XLookupKeysym( &event.xkey, 0 ) ) );
+				break;
+
+			case ButtonRelease:
+				if ( event.xbutton.button == Button1 || event.xbutton.button == Button3 )
+				{
+					windowListener.mouseClicked( ( float )event.xbutton.x / windowWidth,
+												 1.f - ( float )event.xbutton.y / windowHeight,
+												 event.xbutton.button == Button1 );
+				}
+				break;
+		}
+	}
+}
+
+
+namespace platform
+{
+	//-------------------------------------------------------
+	bool initWindow( int width, int height, char const *title, WindowListener const &listener, bool offscreen )
+	{
+		windowListener = listener;
+		windowWidth = width;
+		windowHeight = height;
+		offscreenWindow = offscreen;
+
+		// nothing to create, initOGL() sets up a framebuffer object of the window size
+		if ( offscreen )
+		{
+			windowOpen = true;
+			return true;
+		}
+
+		display = XOpenDisplay( nullptr );
+		if ( !display )
+			return false;
+
+		int visualAttributes[] = { GLX_RGBA, GLX_DOUBLEBUFFER, GLX_RED_SIZE, 8, GLX_GREEN_SIZE, 8, GLX_BLUE_SIZE, 8, None };
+		visualInfo = glXChooseVisual( display, DefaultScreen( display ), visualAttributes );
+		if ( !visualInfo )
+			return false;
+
+		Window root = RootWindow( display, visualInfo->screen );
+		colormap = XCreateColormap( display, root, visualInfo->visual, AllocNone );
+
+		XSetWindowAttributes attributes;
+		attributes.colormap = colormap;
+		attributes.event_mask = KeyPressMask | KeyReleaseMask | ButtonReleaseMask | StructureNotifyMask;
+		window = XCreateWindow( display, root, 0, 0, width, height, 0, visualInfo->depth, InputOutput, visualInfo->visual,
+								CWColormap | CWEventMask, &attributes );
+
+		// fixed size, like the Win32 window without a sizing frame
+		XSizeHints sizeHints;
+		sizeHints.flags = PMinSize | PMaxSize;
+		sizeHints.min_width = sizeHints.max_width = width;
+		sizeHints.min_height = sizeHints.max_height = height;
+		XSetWMNormalHints( display, window, &sizeHints );
+
+		XStoreName( display, window, title );
+		deleteWindowAtom = XInternAtom( display, "WM_DELETE_WINDOW", False );
+		XSetWMProtocols( display, window, &deleteWindowAtom, 1 );
+		XkbSetDetectableAutoRepeat( display, True, nullptr );
+
+		XMapWindow( display, window );
+		XFlush( display );
+		windowOpen = true;
+		return true;
+	}
+
+
+	//-------------------------------------------------------
+	void deinitWindow()
+	{
+		if ( window )
+			XDestroyWindow( display, window );
+		if ( colormap )
+			XFreeColormap( display, colormap );
+		if ( visualInfo )
+			XFree( visualInfo );
+		if ( display )
+			XCloseDisplay( display );
+		window = 0;
+		colormap = 0;
+		visualInfo = nullptr;
+		display = nullptr;
+	}
+
+
+	//-------------------------------------------------------
+	void closeWindow()
+	{
+		windowOpen = false;
+	}
+
+
+	//-------------------------------------------------------
+	bool processWindowMessages()
+	{
+		while ( windowOpen && display && XPending( display ) )
+		{
+			XEvent event;
+			XNextEvent( display, &event );
+			handleEvent( event );
+		}
+		return windowOpen;
+	}
+}
+
+
+//-------------------------------------------------------
+//	opengl related stuff
+//-------------------------------------------------------
+
+namespace
+{
+	GLXContext openGLHandle = nullptr;
+
+	EGLDisplay offscreenDisplay = EGL_NO_DISPLAY;
+	EGLContext offscreenContext = EGL_NO_CONTEXT;
+	GLuint offscreenFramebuffer = 0;
+	GLuint offscreenColorbuffer = 0;
+
+
+	//-------------------------------------------------------
+	template< class Function >
+	bool loadFunction( Function *function, char const *name )
+	{
+		*function = reinterpret_cast< Function >( eglGetProcAddress( name ) );
+		return *function != nullptr;
+	}
+
+
+	//-------------------------------------------------------
+	bool initOffscreenOGL( platform::ContextProfile profile )
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay;
+		if ( !loadFunction( &getPlatformDisplay, "eglGetPlatformDisplayEXT" ) )
+			return false;
+
+		// surfaceless Mesa needs neither a display server nor a GPU, llvmpipe renders on the CPU
+		offscreenDisplay = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr );
+		if ( offscreenDisplay == EGL_NO_DISPLAY || !eglInitialize( offscreenDisplay, nullptr, nullptr ) )
+			return false;
+
+		eglBindAPI( EGL_OPENGL_API );
+		EGLint const coreAttributes[] =
+		{
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		EGLint const *attributes = profile == platform::CONTEXT_CORE ? coreAttributes : nullptr;
+		offscreenContext = eglCreateContext( offscreenDisplay, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes );
+		if ( offscreenContext == EGL_NO_CONTEXT || !eglMakeCurrent( offscreenDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, offscreenContext ) )
+			return false;
+
+		PFNGLGENFRAMEBUFFERSPROC genFramebuffers;
+		PFNGLBINDFRAMEBUFFERPROC bindFramebuffer;
+		PFNGLGENRENDERBUFFERSPROC genRenderbuffers;
+		PFNGLBINDRENDERBUFFERPROC bindRenderbuffer;
+		PFNGLRENDERBUFFERSTORAGEPROC renderbufferStorage;
+		PFNGLFRAMEBUFFERRENDERBUFFERPROC framebufferRenderbuffer;
+		if ( !loadFunction( &genFramebuffers, "glGenFramebuffers" ) ||
+			 !loadFunction( &bindFramebuffer, "glBindFramebuffer" ) ||
+			 !loadFunction( &genRenderbuffers, "glGenRenderbuffers" ) ||
+			 !loadFunction( &bindRenderbuffer, "glBindRenderbuffer" ) ||
+			 !loadFunction( &renderbufferStorage, "glRenderbufferStorage" ) ||
+			 !loadFunction( &framebufferRenderbuffer, "glFramebufferRenderbuffer" ) )
+			return false;
+
+		// the framebuffer object stays bound and stands in for the window
+		genRenderbuffers( 1, &offscreenColorbuffer );
+		bindRenderbuffer( GL_RENDERBUFFER, offscreenColorbuffer );
+		renderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, windowWidth, windowHeight );
+		genFramebuffers( 1, &offscreenFramebuffer );
+		bindFramebuffer( GL_FRAMEBUFFER, offscreenFramebuffer );
+		framebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColorbuffer );
+		glViewport( 0, 0, windowWidth, windowHeight );
+		return glGetError() == GL_NO_ERROR;
+	}
+
+
+	//-------------------------------------------------------
+	// GLX_ARB_create_context wants a framebuffer config, the one of the window's visual
+	GLXContext createCoreContext()
+	{
+		PFNGLXCREATECONTEXTATTRIBSARBPROC createContextAttribs = reinterpret_cast< PFNGLXCREATECONTEXTATTRIBSARBPROC >(
+			glXGetProcAddressARB( reinterpret_cast< GLubyte const* >( "glXCreateContextAttribsARB" ) ) );
+		if ( !createContextAttribs )
+			return nullptr;
+
+		int configCount = 0;
+		GLXFBConfig *configs = glXGetFBConfigs( display, visualInfo->screen, &configCount );
+		GLXFBConfig windowConfig = nullptr;
+		for ( int i = 0; i < configCount && !windowConfig; ++i )
+		{
+			int visualId = 0;
+			if ( glXGetFBConfigAttrib( display, configs[ i ], GLX_VISUAL_ID, &visualId ) == Success && ( VisualID )visualId == visualInfo->visualid )
+				windowConfig = configs[ i ];
+		}
+		if ( configs )
+			XFree( configs );
+		if ( !windowConfig )
+			return nullptr;
+
+		int const attributes[] =
+		{
+			GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+			GLX_CONTEXT_MINOR_VERSION_ARB, 3,
+			GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+			None
+		};
+		return createContextAttribs( display, windowConfig, nullptr, True, attributes );
+	}
+
+
+	//-------------------------------------------------------
+	void deinitOffscreenOGL()
+	{
+		PFNGLDELETEFRAMEBUFFERSPROC deleteFramebuffers;
+		PFNGLDELETERENDERBUFFERSPROC deleteRenderbuffers;
+		if ( offscreenContext != EGL_NO_CONTEXT &&
+			 loadFunction( &deleteFramebuffers, "glDeleteFramebuffers" ) &&
+			 loadFunction( &deleteRenderbuffers, "glDeleteRenderbuffers" ) )
+		{
+			deleteFramebuffers( 1, &offscreenFramebuffer );
+			deleteRenderbuffers( 1, &offscreenColorbuffer );
+		}
+		offscreenFramebuffer = 0;
+		offscreenColorbuffer = 0;
+
+		if ( offscreenDisplay != EGL_NO_DISPLAY )
+		{
+			eglMakeCurrent( offscreenDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+			if ( offscreenContext != EGL_NO_CONTEXT )
+				eglDestroyContext( offscreenDisplay, offscreenContext );
+			eglTerminate( offscreenDisplay );
+		}
+		offscreenContext = EGL_NO_CONTEXT;
+		offscreenDisplay = EGL_NO_DISPLAY;
+	}
+}
+
+
+namespace platform
+{
+	//-------------------------------------------------------
+	bool initOGL( ContextProfile profile )
+	{
+		if ( offscreenWindow )
+			return initOffscreenOGL( profile );
+
+		if ( profile == CONTEXT_CORE )
+			openGLHandle = createCoreContext();
+		else
+			openGLHandle = glXCreateContext( display, visualInfo, nullptr, True );
+		return openGLHandle && glXMakeCurrent( display, window, openGLHandle );
+	}
+
+
+	//-------------------------------------------------------
+	void deinitOGL()
+	{
+		if ( offscreenWindow )
+		{
+			deinitOffscreenOGL();
+			return;
+		}
+
+		glXMakeCurrent( display, None, nullptr );
+		glXDestroyContext( display, openGLHandle );
+		openGLHandle = nullptr;
+	}
+
+
+	//-------------------------------------------------------
+	void swapBuffers()
+	{
+		if ( offscreenWindow )
+			glFlush();
+		else
+			glXSwapBuffers( display, window );
+	}
+
+
+	//-------------------------------------------------------
+	void *getProcAddress( char const *name )
+	{
+		if ( offscreenWindow )
+			return reinterpret_cast< void* >( eglGetProcAddress( name ) );
+		return reinterpret_cast< void* >( glXGetProcAddressARB( reinterpret_cast< GLubyte const* >( name ) ) );
+	}
+}
+
+#endif
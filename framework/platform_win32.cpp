@@ -0,0 +1,315 @@
+#ifdef _WIN32
+
+#include <cassert>
+#include <cstdint>
+#include <windows.h>
+#include <windowsx.h>
+#include <mmsystem.h>
+
+#include "platform.hpp"
+
+
+//-------------------------------------------------------
+//	clock
+//-------------------------------------------------------
+
+namespace
+{
+	// Sleep() granularity while fine pacing is active
+	constexpr UINT TIMER_RESOLUTION_MS = 1;
+}
+
+
+namespace platform
+{
+	long long clockTicks()
+	{
+		LARGE_INTEGER clockTick;
+		QueryPerformanceCounter( &clockTick );
+		return clockTick.QuadPart;
+	}
+
+
+	long long clockFrequency()
+	{
+		static long long const frequency = []()
+		{
+			LARGE_INTEGER clockFrequency;
+			QueryPerformanceFrequency( &clockFrequency );
+			return clockFrequency.QuadPart;
+		}();
+		return frequency;
+	}
+
+
+	void sleepMilliseconds( int milliseconds )
+	{
+		Sleep( ( DWORD )milliseconds );
+	}
+
+
+	void beginFinePacing()
+	{
+		timeBeginPeriod( TIMER_RESOLUTION_MS );
+	}
+
+
+	void endFinePacing()
+	{
+		timeEndPeriod( TIMER_RESOLUTION_MS );
+	}
+}
+
+
+//-------------------------------------------------------
+//	window related stuff
+//-------------------------------------------------------
+
+namespace
+{
+	HWND windowHandle = nullptr;
+	platform::WindowListener windowListener;
+	int windowWidth = 0;
+	int windowHeight = 0;
+
+
+	//-------------------------------------------------------
+	platform::Key toKey( WPARAM wParam )
+	{
+		switch ( wParam )
+		{
+			case 'W':		return platform::KEY_W;
+			case 'A':		return platform::KEY_A;
+			case 'S':		return platform::KEY_S;
+			case 'D':		return platform::KEY_D;
+			case 'I':		return platform::KEY_I;
+			case 'J':		return platform::KEY_J;
+			case 'K':		return platform::KEY_K;
+			case 'L':		return platform::KEY_L;
+			case 'U':		return platform::KEY_U;
+			case 'O':		return platform::KEY_O;
+			case 'H':		return platform::KEY_H;
+			case VK_UP:		return platform::KEY_UP;
+			case VK_DOWN:	return platform::KEY_DOWN;
+			case VK_LEFT:	return platform::KEY_LEFT;
+			case VK_RIGHT:	return platform::KEY_RIGHT;
+			case VK_SPACE:	return platform::KEY_SPACE;
+			case VK_ESCAPE:	return platform::KEY_ESCAPE;
+			default:		return platform::KEY_UNKNOWN;
+		}
+	}
+
+
+	//-------------------------------------------------------
+	LRESULT CALLBACK windowProcedure( HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam )
+	{
+		switch ( message )
+		{
+			case WM_DESTROY:
+				PostQuitMessage( 0 );
+				break;
+
+			case WM_KEYDOWN:
+				// bit 30 is the previous key state, set for auto-repeat
+				windowListener.keyPressed( toKey( wParam ), ( lParam & ( 1 << 30 ) ) != 0 );
+				break;
+
+			case WM_KEYUP:
+				windowListener.keyReleased( toKey( wParam ) );
+				break;
+
+			case WM_LBUTTONUP:
+			case WM_RBUTTONUP:
+				windowListener.mouseClicked( ( float )( GET_X_LPARAM( lParam ) ) / windowWidth,
+											 1.f - ( float )( GET_Y_LPARAM( lParam ) ) / windowHeight,
+											 message == WM_LBUTTONUP );
+				break;
+		}
+		return DefWindowProc( hwnd, message, wParam, lParam );
+	}
+}
+
+
+namespace platform
+{
+	//-------------------------------------------------------
+	bool initWindow( int width, int height, char const *title, WindowListener const &listener, bool offscreen )
+	{
+		windowListener = listener;
+		windowWidth = width;
+		windowHeight = height;
+
+		WNDCLASSEX windowClass;
+
+		windowClass.cbSize = sizeof( windowClass );
+		windowClass.hInstance = GetModuleHandle( nullptr );
+		windowClass.lpszClassName = "WoTS_WndClass";
+		windowClass.lpfnWndProc = windowProcedure;
+		windowClass.style = CS_DBLCLKS;
+
+		windowClass.hIcon = nullptr;
+		windowClass.hIconSm = nullptr;
+		windowClass.hCursor = LoadCursor( nullptr, IDC_ARROW );
+		windowClass.lpszMenuName = nullptr;
+		windowClass.cbClsExtra = 0;
+		windowClass.cbWndExtra = 0;
+		windowClass.hbrBackground = nullptr;
+
+		RegisterClassEx( &windowClass );
+
+		RECT windowRect;
+		windowRect.left = windowRect.top = 0;
+		windowRect.bottom = height;
+		windowRect.right = width;
+		AdjustWindowRect( &windowRect, WS_CAPTION | WS_SYSMENU, FALSE );
+
+		int screenWidth = GetSystemMetrics( SM_CXFULLSCREEN );
+		int screenHeight = GetSystemMetrics( SM_CYFULLSCREEN );
+
+		windowHandle = CreateWindowEx( 0, "WoTS_WndClass", title, WS_CAPTION | WS_SYSMENU,
+								screenWidth / 2 - width / 2, screenHeight / 2 - height / 2, windowRect.right - windowRect.left, windowRect.bottom - windowRect.top,
+								HWND_DESKTOP, nullptr, GetModuleHandle( nullptr ), nullptr );
+		if ( !windowHandle )
+			return false;
+
+		if ( !offscreen )
+			ShowWindow( windowHandle, SW_SHOW );
+		return true;
+	}
+
+
+	//-------------------------------------------------------
+	void deinitWindow()
+	{
+		DestroyWindow( windowHandle );
+		windowHandle = nullptr;
+	}
+
+
+	//-------------------------------------------------------
+	void closeWindow()
+	{
+		DestroyWindow( windowHandle );
+	}
+
+
+	//-------------------------------------------------------
+	bool processWindowMessages()
+	{
+		MSG msg;
+		while ( PeekMessage( &msg, nullptr, 0, 0, PM_REMOVE ) )
+		{
+			if ( msg.message == WM_QUIT )
+				return false;
+			TranslateMessage( &msg );
+			DispatchMessage( &msg );
+		}
+		return true;
+	}
+}
+
+
+//-------------------------------------------------------
+//	opengl related stuff
+//-------------------------------------------------------
+
+namespace
+{
+	HDC windowDC = nullptr;
+	HGLRC openGLHandle = nullptr;
+
+	// WGL_ARB_create_context, not in the Windows SDK headers
+	constexpr int WGL_CONTEXT_MAJOR_VERSION_ARB = 0x2091;
+	constexpr int WGL_CONTEXT_MINOR_VERSION_ARB = 0x2092;
+	constexpr int WGL_CONTEXT_PROFILE_MASK_ARB = 0x9126;
+	constexpr int WGL_CONTEXT_CORE_PROFILE_BIT_ARB = 0x0001;
+	typedef HGLRC ( WINAPI *CreateContextAttribsFunction )( HDC dc, HGLRC shareContext, int const *attributes );
+
+
+	//-------------------------------------------------------
+	// wglCreateContextAttribsARB can only be looked up with a context current, so a legacy
+	// one is made first and replaced
+	HGLRC createCoreContext()
+	{
+		CreateContextAttribsFunction createContextAttribs = reinterpret_cast< CreateContextAttribsFunction >(
+			platform::getProcAddress( "wglCreateContextAttribsARB" ) );
+		if ( !createContextAttribs )
+			return nullptr;
+
+		int const attributes[] =
+		{
+			WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
+			WGL_CONTEXT_MINOR_VERSION_ARB, 3,
+			WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+			0
+		};
+		return createContextAttribs( windowDC, nullptr, attributes );
+	}
+}
+
+
+namespace platform
+{
+	//-------------------------------------------------------
+	bool initOGL( ContextProfile profile )
+	{
+		windowDC = GetDC( windowHandle );
+
+		PIXELFORMATDESCRIPTOR pfd;
+		memset( &pfd, 0, sizeof( pfd ) );
+		pfd.nSize = sizeof( pfd );
+		pfd.nVersion = 1;
+		pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+		pfd.iPixelType = PFD_TYPE_RGBA;
+		pfd.iLayerType = PFD_MAIN_PLANE;
+		int npfd = ChoosePixelFormat( windowDC, &pfd );
+
+		memset( &pfd, 0, sizeof( pfd ) );
+		pfd.nSize = sizeof( pfd );
+		SetPixelFormat( windowDC, npfd, &pfd );
+
+		openGLHandle = wglCreateContext( windowDC );
+		if ( !openGLHandle || !wglMakeCurrent( windowDC, openGLHandle ) )
+			return false;
+		if ( profile == CONTEXT_COMPATIBILITY )
+			return true;
+
+		HGLRC legacyContext = openGLHandle;
+		openGLHandle = createCoreContext();
+		wglMakeCurrent( nullptr, nullptr );
+		wglDeleteContext( legacyContext );
+		return openGLHandle && wglMakeCurrent( windowDC, openGLHandle );
+	}
+
+
+	//-------------------------------------------------------
+	void deinitOGL()
+	{
+		wglMakeCurrent( nullptr, nullptr );
+		wglDeleteContext( openGLHandle );
+		ReleaseDC( windowHandle, windowDC );
+		openGLHandle = nullptr;
+		windowDC = nullptr;
+	}
+
+
+	//-------------------------------------------------------
+	void swapBuffers()
+	{
+		SwapBuffers( windowDC );
+	}
+
+
+	//-------------------------------------------------------
+	void *getProcAddress( char const *name )
+	{
+		// some drivers report failure as small integers instead of null
+		PROC function = wglGetProcAddress( name );
+		std::intptr_t value = reinterpret_cast< std::intptr_t >( function );
+		if ( value >= -1 && value <= 3 )
+			return nullptr;
+		return reinterpret_cast< void* >( function );
+	}
+}
+
+#endif
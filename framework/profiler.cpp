@@ -0,0 +1,405 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "profiler.hpp"
+#include "platform.hpp"
+
+
+//-------------------------------------------------------
+//	clock
+//-------------------------------------------------------
+
+namespace
+{
+	std::int64_t readClock()
+	{
+		return platform::clockTicks();
+	}
+
+
+	double ticksToMilliseconds( std::int64_t ticks )
+	{
+		return ( double )ticks * 1000.0 / ( double )platform::clockFrequency();
+	}
+}
+
+
+//-------------------------------------------------------
+//	frame history
+//-------------------------------------------------------
+
+namespace
+{
+	struct FrameRecord
+	{
+		std::int64_t index;
+		std::int64_t start;
+		std::int64_t phaseStart[ profiler::PHASE_COUNT ];		// first entry into the phase, -1 if not entered
+		std::int64_t phaseTime[ profiler::PHASE_COUNT ];		// summed over all entries into the phase during the frame
+		std::int64_t counters[ profiler::COUNTER_COUNT ];		// -1 if not added to
+	};
+
+
+	// single writer seqlock: the sequence is odd while the record is being overwritten,
+	// readers retry until they copy a record with the same even sequence on both sides
+	struct HistorySlot
+	{
+		std::atomic< std::uint32_t > sequence;
+		FrameRecord record;
+	};
+
+
+	struct TrackState
+	{
+		HistorySlot history[ profiler::HISTORY_SIZE ];
+		std::atomic< std::int64_t > framesPublished;
+
+		// owned by the thread recording the track
+		FrameRecord currentFrame;
+		std::int64_t phaseEnteredAt[ profiler::PHASE_COUNT ];
+		std::int64_t nextFrameIndex;
+	};
+
+
+	TrackState tracks[ profiler::TRACK_COUNT ];
+	thread_local TrackState *openTrack = nullptr;
+
+
+	void publishFrame( TrackState &track, FrameRecord const &record )
+	{
+		HistorySlot &slot = track.history[ record.index % profiler::HISTORY_SIZE ];
+		std::uint32_t sequence = slot.sequence.load( std::memory_order_relaxed );
+		slot.sequence.store( sequence + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+		slot.record = record;
+		slot.sequence.store( sequence + 2, std::memory_order_release );
+		track.framesPublished.store( record.index + 1, std::memory_order_release );
+	}
+
+
+	bool readFrame( TrackState const &track, std::int64_t index, FrameRecord *record )
+	{
+		HistorySlot const &slot = track.history[ index % profiler::HISTORY_SIZE ];
+		while ( true )
+		{
+			std::uint32_t sequenceBefore = slot.sequence.load( std::memory_order_acquire );
+			if ( sequenceBefore & 1 )
+				continue;
+			*record = slot.record;
+			std::atomic_thread_fence( std::memory_order_acquire );
+			if ( slot.sequence.load( std::memory_order_relaxed ) == sequenceBefore )
+				return record->index == index;
+		}
+	}
+
+
+	std::vector< FrameRecord > readHistory( TrackState const &track )
+	{
+		std::int64_t published = track.framesPublished.load( std::memory_order_acquire );
+		std::int64_t first = std::max< std::int64_t >( 0, published - profiler::HISTORY_SIZE );
+
+		std::vector< FrameRecord > frames;
+		frames.reserve( ( size_t )( published - first ) );
+		for ( std::int64_t index = first; index < published; ++index )
+		{
+			FrameRecord record;
+			if ( readFrame( track, index, &record ) )
+				frames.push_back( record );
+		}
+		return frames;
+	}
+
+
+	std::int64_t clockOrigin( std::vector< FrameRecord > const ( &frames )[ profiler::TRACK_COUNT ] )
+	{
+		bool found = false;
+		std::int64_t origin = 0;
+		for ( std::vector< FrameRecord > const &trackFrames : frames )
+		{
+			if ( trackFrames.empty() )
+				continue;
+			origin = found ? std::min( origin, trackFrames.front().start ) : trackFrames.front().start;
+			found = true;
+		}
+		return origin;
+	}
+}
+
+
+//-------------------------------------------------------
+//	recording
+//-------------------------------------------------------
+
+namespace profiler
+{
+	void beginFrame( Track track )
+	{
+		assert( !openTrack );
+		assert( track >= 0 && track < TRACK_COUNT );
+		openTrack = &tracks[ track ];
+
+		FrameRecord &frame = openTrack->currentFrame;
+		frame.index = openTrack->nextFrameIndex++;
+		frame.start = readClock();
+		for ( int phase = 0; phase < PHASE_COUNT; ++phase )
+		{
+			frame.phaseStart[ phase ] = -1;
+			frame.phaseTime[ phase ] = 0;
+		}
+		for ( int counter = 0; counter < COUNTER_COUNT; ++counter )
+			frame.counters[ counter ] = -1;
+		beginPhase( PHASE_FRAME );
+	}
+
+
+	void endFrame()
+	{
+		assert( openTrack );
+		endPhase( PHASE_FRAME );
+		publishFrame( *openTrack, openTrack->currentFrame );
+		openTrack = nullptr;
+	}
+
+
+	void beginPhase( Phase phase )
+	{
+		if ( !openTrack )
+			return;
+		std::int64_t now = readClock();
+		openTrack->phaseEnteredAt[ phase ] = now;
+		if ( openTrack->currentFrame.phaseStart[ phase ] < 0 )
+			openTrack->currentFrame.phaseStart[ phase ] = now;
+	}
+
+
+	void endPhase( Phase phase )
+	{
+		if ( !openTrack )
+			return;
+		openTrack->currentFrame.phaseTime[ phase ] += readClock() - openTrack->phaseEnteredAt[ phase ];
+	}
+
+
+	void addCount( Counter counter, long long amount )
+	{
+		assert( counter >= 0 && counter < COUNTER_COUNT );
+		if ( !openTrack )
+			return;
+		std::int64_t &count = openTrack->currentFrame.counters[ counter ];
+		count = std::max< std::int64_t >( count, 0 ) + amount;
+	}
+}
+
+
+//-------------------------------------------------------
+//	reports
+//-------------------------------------------------------
+
+namespace profiler
+{
+	char const *trackName( Track track )
+	{
+		static char const *const names[ TRACK_COUNT ] =
+		{
+			"render",
+			"simulation",
+		};
+		assert( track >= 0 && track < TRACK_COUNT );
+		return names[ track ];
+	}
+
+
+	char const *phaseName( Phase phase )
+	{
+		static char const *const names[ PHASE_COUNT ] =
+		{
+			"frame",
+			"processWindowMessages",
+			"drainInput",
+			"game::update",
+			"scene::update",
+			"world transforms",
+			"mesh updates",
+			"updateParticles",
+			"sea particles",
+			"publishSnapshot",
+			"scene::draw",
+			"drawParticles",
+			"mesh draws",
+			"drawGoalMarker",
+			"hud",
+			"execute commands",
+			"capture",
+			"SwapBuffers",
+			"rasterize",
+		};
+		assert( phase >= 0 && phase < PHASE_COUNT );
+		return names[ phase ];
+	}
+
+
+	char const *counterName( Counter counter )
+	{
+		static char const *const names[ COUNTER_COUNT ] =
+		{
+			"GL state changes",
+			"GL state filtered",
+			"meshes culled",
+			"particles culled",
+			"grid cells visited",
+			"allocations",
+			"meshes created",
+			"mesh storage growth",
+			"dirty meshes",
+			"clean meshes",
+		};
+		assert( counter >= 0 && counter < COUNTER_COUNT );
+		return names[ counter ];
+	}
+
+
+	Summary summarize( Track track, Phase phase )
+	{
+		std::vector< FrameRecord > frames = readHistory( tracks[ track ] );
+
+		std::vector< double > times;
+		times.reserve( frames.size() );
+		for ( FrameRecord const &frame : frames )
+			if ( frame.phaseStart[ phase ] >= 0 )
+				times.push_back( ticksToMilliseconds( frame.phaseTime[ phase ] ) );
+
+		Summary summary = { ( int )times.size(), 0.0, 0.0, 0.0 };
+		if ( times.empty() )
+			return summary;
+
+		std::sort( times.begin(), times.end() );
+		summary.p50 = times[ ( times.size() - 1 ) / 2 ];
+		summary.p99 = times[ ( times.size() - 1 ) * 99 / 100 ];
+		summary.max = times.back();
+		return summary;
+	}
+
+
+	CounterSummary summarize( Track track, Counter counter )
+	{
+		std::vector< FrameRecord > frames = readHistory( tracks[ track ] );
+
+		CounterSummary summary = { 0, 0.0, 0 };
+		double total = 0.0;
+		for ( FrameRecord const &frame : frames )
+		{
+			if ( frame.counters[ counter ] < 0 )
+				continue;
+			++summary.frames;
+			total += ( double )frame.counters[ counter ];
+			summary.max = std::max( summary.max, ( long long )frame.counters[ counter ] );
+		}
+		if ( summary.frames > 0 )
+			summary.mean = total / summary.frames;
+		return summary;
+	}
+
+
+	double latestPhaseTime( Track track, Phase phase )
+	{
+		assert( track >= 0 && track < TRACK_COUNT );
+		assert( phase >= 0 && phase < PHASE_COUNT );
+		std::int64_t published = tracks[ track ].framesPublished.load( std::memory_order_acquire );
+		FrameRecord frame;
+		if ( published == 0 || !readFrame( tracks[ track ], published - 1, &frame ) )
+			return 0.0;
+		return ticksToMilliseconds( frame.phaseTime[ phase ] );
+	}
+
+
+	bool exportCsv( char const *path )
+	{
+		FILE *file = std::fopen( path, "w" );
+		if ( !file )
+			return false;
+
+		std::vector< FrameRecord > frames[ TRACK_COUNT ];
+		for ( int track = 0; track < TRACK_COUNT; ++track )
+			frames[ track ] = readHistory( tracks[ track ] );
+		std::int64_t origin = clockOrigin( frames );
+
+		std::fprintf( file, "track,frame,start_ms" );
+		for ( int phase = 0; phase < PHASE_COUNT; ++phase )
+			std::fprintf( file, ",%s_ms", phaseName( ( Phase )phase ) );
+		for ( int counter = 0; counter < COUNTER_COUNT; ++counter )
+			std::fprintf( file, ",%s", counterName( ( Counter )counter ) );
+		std::fprintf( file, "\n" );
+
+		for ( int track = 0; track < TRACK_COUNT; ++track )
+		{
+			for ( FrameRecord const &frame : frames[ track ] )
+			{
+				std::fprintf( file, "%s,%lld,%.4f", trackName( ( Track )track ), ( long long )frame.index, ticksToMilliseconds( frame.start - origin ) );
+				for ( int phase = 0; phase < PHASE_COUNT; ++phase )
+					std::fprintf( file, ",%.4f", ticksToMilliseconds( frame.phaseTime[ phase ] ) );
+				for ( int counter = 0; counter < COUNTER_COUNT; ++counter )
+					std::fprintf( file, ",%lld", ( long long )std::max< std::int64_t >( frame.counters[ counter ], 0 ) );
+				std::fprintf( file, "\n" );
+			}
+		}
+
+		return std::fclose( file ) == 0;
+	}
+
+
+	bool exportChromeTrace( char const *path )
+	{
+		FILE *file = std::fopen( path, "w" );
+		if ( !file )
+			return false;
+
+		std::vector< FrameRecord > frames[ TRACK_COUNT ];
+		for ( int track = 0; track < TRACK_COUNT; ++track )
+			frames[ track ] = readHistory( tracks[ track ] );
+		std::int64_t origin = clockOrigin( frames );
+
+		// one complete event per phase and frame; a phase entered several times in a frame
+		// is shown once, starting at its first entry and lasting for the summed time
+		std::fprintf( file, "{\"traceEvents\":[\n" );
+		for ( int track = 0; track < TRACK_COUNT; ++track )
+		{
+			std::fprintf( file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+						  track == 0 ? "" : ",\n", track + 1, trackName( ( Track )track ) );
+		}
+		for ( int track = 0; track < TRACK_COUNT; ++track )
+		{
+			for ( FrameRecord const &frame : frames[ track ] )
+			{
+				for ( int phase = 0; phase < PHASE_COUNT; ++phase )
+				{
+					if ( frame.phaseStart[ phase ] < 0 )
+						continue;
+					std::fprintf( file, ",\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%lld}}",
+								  phaseName( ( Phase )phase ),
+								  track + 1,
+								  ticksToMilliseconds( frame.phaseStart[ phase ] - origin ) * 1000.0,
+								  ticksToMilliseconds( frame.phaseTime[ phase ] ) * 1000.0,
+								  ( long long )frame.index );
+				}
+
+				// counter tracks, drawn by the viewer as graphs under the threads
+				for ( int counter = 0; counter < COUNTER_COUNT; ++counter )
+				{
+					if ( frame.counters[ counter ] < 0 )
+						continue;
+					std::fprintf( file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"count\":%lld}}",
+								  counterName( ( Counter )counter ),
+								  ticksToMilliseconds( frame.start - origin ) * 1000.0,
+								  ( long long )frame.counters[ counter ] );
+				}
+			}
+		}
+		std::fprintf( file, "\n],\"displayTimeUnit\":\"ms\"}\n" );
+
+		return std::fclose( file ) == 0;
+	}
+}
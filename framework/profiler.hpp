@@ -0,0 +1,108 @@
+
+
+namespace profiler
+{
+	enum Phase
+	{
+		PHASE_FRAME,
+		PHASE_WINDOW_MESSAGES,
+		PHASE_DRAIN_INPUT,
+		PHASE_GAME_UPDATE,
+		PHASE_SCENE_UPDATE,
+		PHASE_TRANSFORMS,
+		PHASE_MESH_UPDATE,
+		PHASE_PARTICLE_UPDATE,
+		PHASE_SEA_PARTICLES,
+		PHASE_PUBLISH_SNAPSHOT,
+		PHASE_SCENE_DRAW,
+		PHASE_DRAW_PARTICLES,
+		PHASE_DRAW_MESHES,
+		PHASE_DRAW_GOAL_MARKER,
+		PHASE_DRAW_HUD,
+		PHASE_EXECUTE_COMMANDS,
+		PHASE_CAPTURE,
+		PHASE_SWAP_BUFFERS,
+		PHASE_RASTERIZE,
+		PHASE_COUNT
+	};
+
+	// per frame event counts next to the phase timings
+	enum Counter
+	{
+		COUNTER_GL_STATE_CHANGES,
+		COUNTER_GL_STATE_CHANGES_FILTERED,
+		COUNTER_MESHES_CULLED,
+		COUNTER_PARTICLES_CULLED,
+		COUNTER_GRID_CELLS_VISITED,
+		COUNTER_ALLOCATIONS,
+		COUNTER_MESHES_CREATED,
+		COUNTER_MESH_STORAGE_GROWTH,
+		COUNTER_MESHES_DIRTY,		// world transform recomputed in the tick, or drawn blended between ticks
+		COUNTER_MESHES_CLEAN,		// left as they were, or drawn as they were in the last tick
+		COUNTER_COUNT
+	};
+
+	// every thread records its own frames: the renderer one per drawn frame, the simulation one per tick
+	enum Track
+	{
+		TRACK_RENDER,
+		TRACK_SIMULATION,
+		TRACK_COUNT
+	};
+
+	// frames kept in the history ring buffer of each track
+	constexpr int HISTORY_SIZE = 1024;
+
+	struct Summary
+	{
+		int frames;
+		double p50;		// milliseconds
+		double p99;
+		double max;
+	};
+
+	struct CounterSummary
+	{
+		int frames;			// frames the counter was added to
+		double mean;		// per frame
+		long long max;
+	};
+
+	// a track is recorded from a single thread at a time, phases go to the frame open on the
+	// calling thread and are ignored outside of frames; history can be read from any thread
+	void beginFrame( Track track );
+	void endFrame();
+	void beginPhase( Phase phase );
+	void endPhase( Phase phase );
+	void addCount( Counter counter, long long amount );
+
+	char const *trackName( Track track );
+	char const *phaseName( Phase phase );
+	char const *counterName( Counter counter );
+	Summary summarize( Track track, Phase phase );
+	CounterSummary summarize( Track track, Counter counter );
+
+	// milliseconds spent in the phase during the track's last finished frame, without copying the history
+	double latestPhaseTime( Track track, Phase phase );
+	bool exportCsv( char const *path );
+	bool exportChromeTrace( char const *path );
+
+
+	class ScopedPhase
+	{
+	public:
+		explicit ScopedPhase( Phase phase ) : phase( phase ) { beginPhase( phase ); }
+		~ScopedPhase() { endPhase( phase ); }
+
+		ScopedPhase( ScopedPhase const & ) = delete;
+		ScopedPhase &operator = ( ScopedPhase const & ) = delete;
+
+	private:
+		Phase phase;
+	};
+}
+
+
+#define PROFILER_CONCAT_IMPL( a, b ) a##b
+#define PROFILER_CONCAT( a, b ) PROFILER_CONCAT_IMPL( a, b )
+#define PROFILE_SCOPE( phase ) profiler::ScopedPhase PROFILER_CONCAT( profileScope, __LINE__ )( phase )
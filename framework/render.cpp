@@ -0,0 +1,542 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "render.hpp"
+
+
+namespace
+{
+	// authored pointing along +y, turned by -90 degrees and scaled once instead of on every draw
+	std::vector< render::Vertex > toMeshSpace( std::vector< render::Vertex > vertices, float scale )
+	{
+		for ( render::Vertex &vertex : vertices )
+		{
+			float x = vertex.x;
+			vertex.x = vertex.y * scale;
+			vertex.y = -x * scale;
+		}
+		return vertices;
+	}
+
+
+	float boundingRadius( render::MeshGeometry const &geometry )
+	{
+		float radius = 0.f;
+		for ( std::vector< render::Vertex > const *vertices : { &geometry.triangles, &geometry.outline } )
+			for ( render::Vertex const &vertex : *vertices )
+				radius = std::max( radius, std::sqrt( vertex.x * vertex.x + vertex.y * vertex.y ) );
+		return radius;
+	}
+
+
+	render::MeshGeometry shipGeometry()
+	{
+		float const r = 0.1f, g = 0.3f, b = 0.6f;
+		float const outlineR = 0.4f, outlineG = 0.8f, outlineB = 1.f;
+
+		render::MeshGeometry geometry;
+		geometry.triangles = toMeshSpace(
+		{
+			{ -0.1f, -0.4f, r, g, b },
+			{ 0.1f, -0.4f, r, g, b },
+			{ 0.1f, 0.4f, r, g, b },
+
+			{ -0.1f, 0.4f, r, g, b },
+			{ 0.1f, 0.4f, r, g, b },
+			{ -0.1f, -0.4f, r, g, b },
+
+			{ -0.1f, -0.4f, r, g, b },
+			{ -0.1f, 0.4f, r, g, b },
+			{ -0.15f, -0.1f, r, g, b },
+
+			{ 0.1f, -0.4f, r, g, b },
+			{ 0.1f, 0.4f, r, g, b },
+			{ 0.15f, -0.1f, r, g, b },
+		}, 0.8f );
+		geometry.outline = toMeshSpace(
+		{
+			{ -0.1f, -0.4f, outlineR, outlineG, outlineB },
+			{ 0.1f, -0.4f, outlineR, outlineG, outlineB },
+			{ 0.15f, -0.1f, outlineR, outlineG, outlineB },
+			{ 0.1f, 0.4f, outlineR, outlineG, outlineB },
+			{ -0.1f, 0.4f, outlineR, outlineG, outlineB },
+			{ -0.15f, -0.1f, outlineR, outlineG, outlineB },
+		}, 0.8f );
+		geometry.outlineWidth = 2.f;
+		geometry.boundingRadius = boundingRadius( geometry );
+		return geometry;
+	}
+
+
+	render::MeshGeometry aircraftGeometry()
+	{
+		float const r = 0.5f, g = 0.6f, b = 0.1f;
+		float const outlineR = 0.8f, outlineG = 1.f, outlineB = 0.2f;
+
+		render::MeshGeometry geometry;
+		geometry.triangles = toMeshSpace(
+		{
+			{ -0.06f, -0.1f, r, g, b },
+			{ 0.06f, -0.1f, r, g, b },
+			{ 0.f, 0.1f, r, g, b },
+			{ -0.1f, -0.1f, r, g, b },
+			{ 0.1f, -0.1f, r, g, b },
+			{ 0.f, 0.0f, r, g, b },
+		}, 1.f );
+		geometry.outline = toMeshSpace(
+		{
+			{ -0.1f, -0.1f, outlineR, outlineG, outlineB },
+			{ 0.1f, -0.1f, outlineR, outlineG, outlineB },
+			{ 0.04f, -0.04f, outlineR, outlineG, outlineB },
+			{ 0.f, 0.1f, outlineR, outlineG, outlineB },
+			{ -0.04f, -0.04f, outlineR, outlineG, outlineB },
+		}, 1.f );
+		geometry.outlineWidth = 2.f;
+		geometry.boundingRadius = boundingRadius( geometry );
+		return geometry;
+	}
+}
+
+
+namespace render
+{
+	MeshGeometry const &meshGeometry( MeshType type )
+	{
+		static MeshGeometry const geometries[ MESH_TYPE_COUNT ] =
+		{
+			shipGeometry(),
+			aircraftGeometry(),
+		};
+		assert( type >= 0 && type < MESH_TYPE_COUNT );
+		return geometries[ type ];
+	}
+}
+
+
+//-------------------------------------------------------
+//	glyph atlas
+//-------------------------------------------------------
+
+namespace
+{
+	constexpr char FIRST_GLYPH = ' ';
+	constexpr char LAST_GLYPH = '_';
+	constexpr int ATLAS_COLUMNS = 16;
+
+	// 5 pixels per row, the top bit is the left one
+	unsigned char const FONT[ LAST_GLYPH - FIRST_GLYPH + 1 ][ 7 ] =
+	{
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// ' '
+		{ 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },		// '!'
+		{ 0x0a, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00 },		// '"'
+		{ 0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a },		// '#'
+		{ 0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04 },		// '$'
+		{ 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },		// '%'
+		{ 0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d },		// '&'
+		{ 0x0c, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 },		// '\''
+		{ 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },		// '('
+		{ 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },		// ')'
+		{ 0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00 },		// '*'
+		{ 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00 },		// '+'
+		{ 0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08 },		// ','
+		{ 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 },		// '-'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c },		// '.'
+		{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },		// '/'
+		{ 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e },		// '0'
+		{ 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e },		// '1'
+		{ 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f },		// '2'
+		{ 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e },		// '3'
+		{ 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 },		// '4'
+		{ 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e },		// '5'
+		{ 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e },		// '6'
+		{ 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },		// '7'
+		{ 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e },		// '8'
+		{ 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c },		// '9'
+		{ 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 },		// ':'
+		{ 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08 },		// ';'
+		{ 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },		// '<'
+		{ 0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00 },		// '='
+		{ 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },		// '>'
+		{ 0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },		// '?'
+		{ 0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e },		// '@'
+		{ 0x0e, 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11 },		// 'A'
+		{ 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e },		// 'B'
+		{ 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e },		// 'C'
+		{ 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c },		// 'D'
+		{ 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f },		// 'E'
+		{ 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 },		// 'F'
+		{ 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f },		// 'G'
+		{ 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },		// 'H'
+		{ 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e },		// 'I'
+		{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c },		// 'J'
+		{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },		// 'K'
+		{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f },		// 'L'
+		{ 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 },		// 'M'
+		{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },		// 'N'
+		{ 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },		// 'O'
+		{ 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 },		// 'P'
+		{ 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d },		// 'Q'
+		{ 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 },		// 'R'
+		{ 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e },		// 'S'
+		{ 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },		// 'T'
+		{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },		// 'U'
+		{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 },		// 'V'
+		{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a },		// 'W'
+		{ 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 },		// 'X'
+		{ 0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04 },		// 'Y'
+		{ 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f },		// 'Z'
+		{ 0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e },		// '['
+		{ 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },		// '\\'
+		{ 0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e },		// ']'
+		{ 0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00 },		// '^'
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f },		// '_'
+	};
+
+
+	render::GlyphAtlas buildGlyphAtlas()
+	{
+		render::GlyphAtlas atlas;
+		atlas.width = 128;
+		atlas.height = 32;
+		atlas.coverage.assign( ( size_t )atlas.width * atlas.height, 0 );
+
+		for ( int glyph = 0; glyph <= LAST_GLYPH - FIRST_GLYPH; ++glyph )
+		{
+			int cellX = glyph % ATLAS_COLUMNS * render::GLYPH_WIDTH;
+			int cellY = glyph / ATLAS_COLUMNS * render::GLYPH_HEIGHT;
+			for ( int row = 0; row < 7; ++row )
+				for ( int column = 0; column < 5; ++column )
+					if ( FONT[ glyph ][ row ] & ( 0x10 >> column ) )
+						atlas.coverage[ ( size_t )( cellY + row ) * atlas.width + cellX + column ] = 255;
+		}
+		return atlas;
+	}
+}
+
+
+namespace render
+{
+	GlyphAtlas const &glyphAtlas()
+	{
+		static GlyphAtlas const atlas = buildGlyphAtlas();
+		return atlas;
+	}
+
+
+	bool glyphCell( char character, int *x, int *y )
+	{
+		if ( character >= 'a' && character <= 'z' )
+			character = character - 'a' + 'A';
+		if ( character <= FIRST_GLYPH || character > LAST_GLYPH )
+			return false;
+
+		int glyph = character - FIRST_GLYPH;
+		*x = glyph % ATLAS_COLUMNS * GLYPH_WIDTH;
+		*y = glyph / ATLAS_COLUMNS * GLYPH_HEIGHT;
+		return true;
+	}
+}
+
+
+//-------------------------------------------------------
+//	renderers
+//-------------------------------------------------------
+
+namespace render
+{
+	Renderer::~Renderer()
+	{
+	}
+
+
+	bool Renderer::captureFrame( Image *image )
+	{
+		readFrame( image );
+		return true;
+	}
+
+
+	bool Renderer::finishCapture( Image *image )
+	{
+		return false;
+	}
+}
+
+
+//-------------------------------------------------------
+//	command buffer
+//-------------------------------------------------------
+
+namespace
+{
+	// the data of a single command in place, of several copied one after the other into scratch
+	template< class Item, class Command >
+	Item const *gatherRun( std::vector< Item > const &items, Command const *run, int runCount, std::vector< Item > &scratch, int *count )
+	{
+		*count = run[ 0 ].count;
+		if ( runCount == 1 )
+			return items.data() + run[ 0 ].first;
+
+		scratch.clear();
+		for ( int i = 0; i < runCount; ++i )
+			scratch.insert( scratch.end(), items.begin() + run[ i ].first, items.begin() + run[ i ].first + run[ i ].count );
+		*count = ( int )scratch.size();
+		return scratch.data();
+	}
+}
+
+
+namespace render
+{
+	void CommandBuffer::clear()
+	{
+		commands.clear();
+		vertices.clear();
+		instances.clear();
+		glyphs.clear();
+	}
+
+
+	void CommandBuffer::record( Layer layer, Primitive primitive, MeshType meshType, float size, int first, int count )
+	{
+		assert( layer >= 0 && layer < LAYER_COUNT );
+		assert( size >= 0.f );
+
+		// sizes in 1/16 pixels; sorted by them, though runs only merge on the exact float
+		std::uint64_t quantizedSize = std::min( ( std::uint64_t )( size * 16.f ), ( std::uint64_t )0xffff );
+		std::uint64_t key = ( std::uint64_t )layer << 56
+						  | ( std::uint64_t )primitive << 48
+						  | ( std::uint64_t )meshType << 40
+						  | quantizedSize << 24
+						  | ( ( std::uint32_t )commands.size() & 0xffffff );
+		commands.push_back( Command{ key, primitive, meshType, size, first, count } );
+	}
+
+
+	void CommandBuffer::drawParticles( Layer layer, Vertex const *particles, int count, float pointSize )
+	{
+		if ( count <= 0 )
+			return;
+		record( layer, PRIMITIVE_POINTS, MESH_SHIP, pointSize, ( int )vertices.size(), count );
+		vertices.insert( vertices.end(), particles, particles + count );
+	}
+
+
+	void CommandBuffer::drawMesh( Layer layer, MeshType type, Instance const &instance )
+	{
+		record( layer, PRIMITIVE_MESHES, type, 0.f, ( int )instances.size(), 1 );
+		instances.push_back( instance );
+	}
+
+
+	void CommandBuffer::drawLines( Layer layer, Vertex const *lines, int count, float width )
+	{
+		assert( count % 2 == 0 );
+		if ( count <= 0 )
+			return;
+		record( layer, PRIMITIVE_LINES, MESH_SHIP, width, ( int )vertices.size(), count );
+		vertices.insert( vertices.end(), lines, lines + count );
+	}
+
+
+	void CommandBuffer::drawGlyphs( Layer layer, Glyph const *text, int count, float scale )
+	{
+		if ( count <= 0 )
+			return;
+		record( layer, PRIMITIVE_GLYPHS, MESH_SHIP, scale, ( int )glyphs.size(), count );
+		glyphs.insert( glyphs.end(), text, text + count );
+	}
+
+
+	void CommandBuffer::drawScreenLines( Layer layer, Vertex const *lines, int count )
+	{
+		assert( count % 2 == 0 );
+		if ( count <= 0 )
+			return;
+		record( layer, PRIMITIVE_SCREEN_LINES, MESH_SHIP, 0.f, ( int )vertices.size(), count );
+		vertices.insert( vertices.end(), lines, lines + count );
+	}
+
+
+	// draws commands[ 0 .. runCount ) starting at command, which all share its state
+	void CommandBuffer::flush( Renderer &renderer, Command const &command, int runCount )
+	{
+		int count;
+		if ( command.primitive == PRIMITIVE_MESHES )
+		{
+			Instance const *data = gatherRun( instances, &command, runCount, runInstances, &count );
+			renderer.drawMeshes( command.meshType, data, count );
+		}
+		else if ( command.primitive == PRIMITIVE_GLYPHS )
+		{
+			Glyph const *data = gatherRun( glyphs, &command, runCount, runGlyphs, &count );
+			renderer.drawGlyphs( data, count, command.size );
+		}
+		else
+		{
+			Vertex const *data = gatherRun( vertices, &command, runCount, runVertices, &count );
+			if ( command.primitive == PRIMITIVE_POINTS )
+				renderer.drawParticles( data, count, command.size );
+			else if ( command.primitive == PRIMITIVE_LINES )
+				renderer.drawLines( data, count, command.size );
+			else
+				renderer.drawScreenLines( data, count );
+		}
+	}
+
+
+	void CommandBuffer::execute( Renderer &renderer )
+	{
+		// the recording order in the key keeps equal states in submission order
+		std::sort( commands.begin(), commands.end(), []( Command const &a, Command const &b ) { return a.key < b.key; } );
+
+		auto sameState = []( Command const &a, Command const &b )
+		{
+			return ( a.key >> 40 ) == ( b.key >> 40 ) && a.size == b.size;
+		};
+		for ( size_t begin = 0, end; begin < commands.size(); begin = end )
+		{
+			for ( end = begin + 1; end < commands.size() && sameState( commands[ begin ], commands[ end ] ); ++end )
+				;
+			flush( renderer, commands[ begin ], ( int )( end - begin ) );
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	image files
+//-------------------------------------------------------
+
+namespace
+{
+	void writeBigEndian( std::vector< unsigned char > &buffer, std::uint32_t value )
+	{
+		for ( int shift = 24; shift >= 0; shift -= 8 )
+			buffer.push_back( ( unsigned char )( value >> shift ) );
+	}
+
+
+	std::uint32_t crc32( unsigned char const *data, size_t size, std::uint32_t crc = 0 )
+	{
+		static std::uint32_t const *const table = []()
+		{
+			static std::uint32_t entries[ 256 ];
+			for ( std::uint32_t n = 0; n < 256; ++n )
+			{
+				std::uint32_t c = n;
+				for ( int bit = 0; bit < 8; ++bit )
+					c = c & 1 ? 0xedb88320u ^ ( c >> 1 ) : c >> 1;
+				entries[ n ] = c;
+			}
+			return entries;
+		}();
+
+		crc = ~crc;
+		for ( size_t i = 0; i < size; ++i )
+			crc = table[ ( crc ^ data[ i ] ) & 0xff ] ^ ( crc >> 8 );
+		return ~crc;
+	}
+
+
+	void writeChunk( std::vector< unsigned char > &file, char const *type, std::vector< unsigned char > const &data )
+	{
+		writeBigEndian( file, ( std::uint32_t )data.size() );
+		size_t typeStart = file.size();
+		file.insert( file.end(), type, type + 4 );
+		file.insert( file.end(), data.begin(), data.end() );
+		writeBigEndian( file, crc32( file.data() + typeStart, file.size() - typeStart ) );
+	}
+
+
+	// stored deflate blocks: no compression library needed, images are only a few megabytes
+	std::vector< unsigned char > encodePng( render::Image const &image )
+	{
+		size_t rowSize = ( size_t )image.width * 3;
+		std::vector< unsigned char > scanlines;
+		scanlines.reserve( ( rowSize + 1 ) * image.height );
+		for ( int y = 0; y < image.height; ++y )
+		{
+			scanlines.push_back( 0 );
+			scanlines.insert( scanlines.end(), image.pixels.begin() + y * rowSize, image.pixels.begin() + ( y + 1 ) * rowSize );
+		}
+
+		std::vector< unsigned char > deflate = { 0x78, 0x01 };
+		constexpr size_t MAX_BLOCK = 65535;
+		for ( size_t offset = 0; offset < scanlines.size() || offset == 0; offset += MAX_BLOCK )
+		{
+			size_t size = std::min( MAX_BLOCK, scanlines.size() - offset );
+			deflate.push_back( offset + size == scanlines.size() ? 1 : 0 );
+			deflate.push_back( ( unsigned char )size );
+			deflate.push_back( ( unsigned char )( size >> 8 ) );
+			deflate.push_back( ( unsigned char )~size );
+			deflate.push_back( ( unsigned char )( ~size >> 8 ) );
+			deflate.insert( deflate.end(), scanlines.begin() + offset, scanlines.begin() + offset + size );
+		}
+
+		std::uint32_t a = 1, b = 0;
+		for ( unsigned char byte : scanlines )
+		{
+			a = ( a + byte ) % 65521;
+			b = ( b + a ) % 65521;
+		}
+		writeBigEndian( deflate, ( b << 16 ) | a );
+
+		std::vector< unsigned char > header;
+		writeBigEndian( header, ( std::uint32_t )image.width );
+		writeBigEndian( header, ( std::uint32_t )image.height );
+		header.insert( header.end(), { 8, 2, 0, 0, 0 } );		// 8 bit RGB, no interlacing
+
+		std::vector< unsigned char > file = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		writeChunk( file, "IHDR", header );
+		writeChunk( file, "IDAT", deflate );
+		writeChunk( file, "IEND", {} );
+		return file;
+	}
+}
+
+
+namespace render
+{
+	bool writeImage( Image const &image, char const *path )
+	{
+		assert( image.pixels.size() == ( size_t )image.width * image.height * 3 );
+
+		FILE *file = std::fopen( path, "wb" );
+		if ( !file )
+			return false;
+
+		size_t length = std::strlen( path );
+		bool written;
+		if ( length >= 4 && std::strcmp( path + length - 4, ".png" ) == 0 )
+		{
+			std::vector< unsigned char > png = encodePng( image );
+			written = std::fwrite( png.data(), 1, png.size(), file ) == png.size();
+		}
+		else
+		{
+			std::fprintf( file, "P6\n%d %d\n255\n", image.width, image.height );
+			written = std::fwrite( image.pixels.data(), 1, image.pixels.size(), file ) == image.pixels.size();
+		}
+
+		return std::fclose( file ) == 0 && written;
+	}
+
+
+	std::string numberedPath( char const *path, long long number )
+	{
+		std::string numbered = path;
+		size_t slash = numbered.find_last_of( "/\\" );
+		size_t dot = numbered.find_last_of( '.' );
+		if ( dot == std::string::npos || ( slash != std::string::npos && dot < slash ) )
+			dot = numbered.size();
+
+		char digits[ 32 ];
+		std::snprintf( digits, sizeof( digits ), "_%06lld", number );
+		return numbered.insert( dot, digits );
+	}
+}
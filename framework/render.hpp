@@ -0,0 +1,232 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	mesh geometry shared by every renderer
+//-------------------------------------------------------
+
+namespace render
+{
+	enum MeshType
+	{
+		MESH_SHIP,
+		MESH_AIRCRAFT,
+		MESH_TYPE_COUNT
+	};
+
+	struct Color
+	{
+		float r;
+		float g;
+		float b;
+	};
+
+	struct Vertex
+	{
+		float x;
+		float y;
+		float r;
+		float g;
+		float b;
+	};
+
+	// in mesh space, pointing along +x like an angle of zero
+	struct MeshGeometry
+	{
+		std::vector< Vertex > triangles;
+		std::vector< Vertex > outline;		// closed line loop
+		float outlineWidth;
+		float boundingRadius;		// around the mesh origin, not counting the outline width
+	};
+
+	MeshGeometry const &meshGeometry( MeshType type );
+}
+
+
+//-------------------------------------------------------
+//	glyph atlas shared by every renderer
+//-------------------------------------------------------
+
+namespace render
+{
+	// a 5x7 pixel font in cells of GLYPH_WIDTH x GLYPH_HEIGHT, ' ' to '_' in rows of 16;
+	// lower case letters are drawn upper case, anything else is left blank
+	constexpr int GLYPH_WIDTH = 6;
+	constexpr int GLYPH_HEIGHT = 8;
+
+	// power of two sized for old drivers, coverage is 0 or 255 with rows top to bottom
+	struct GlyphAtlas
+	{
+		int width;
+		int height;
+		std::vector< unsigned char > coverage;
+	};
+
+	GlyphAtlas const &glyphAtlas();
+
+	// top left corner of the character's cell in the atlas, false for blank characters
+	bool glyphCell( char character, int *x, int *y );
+}
+
+
+//-------------------------------------------------------
+//	renderers
+//-------------------------------------------------------
+
+namespace render
+{
+	struct Instance
+	{
+		float x;
+		float y;
+		float angle;
+	};
+
+	// a character drawn from the glyph atlas, x and y are the top left corner of its cell on screen
+	struct Glyph
+	{
+		float x;
+		float y;
+		char character;
+		Color color;
+	};
+
+	// world rectangle shown on screen
+	struct View
+	{
+		float centerX;
+		float centerY;
+		float width;
+		float height;
+	};
+
+	// 8 bit RGB, rows top to bottom
+	struct Image
+	{
+		int width = 0;
+		int height = 0;
+		std::vector< unsigned char > pixels;
+	};
+
+
+	// everything scene::draw() puts on screen, in world space unless said otherwise; widths and sizes are in pixels
+	class Renderer
+	{
+	public:
+		virtual ~Renderer();
+
+		// clears to clearColor and shows the view
+		virtual void beginFrame( View const &view, Color clearColor ) = 0;
+		virtual void endFrame() = 0;
+
+		virtual void drawParticles( Vertex const *particles, int count, float pointSize ) = 0;
+		virtual void drawMeshes( MeshType type, Instance const *instances, int count ) = 0;
+		virtual void drawLines( Vertex const *vertices, int count, float width ) = 0;		// a segment per vertex pair
+
+		// screen space in pixels from the top left corner, whatever the view; glyphs are scaled by
+		// a whole number of pixels per atlas pixel and screen lines are one pixel wide
+		virtual void drawGlyphs( Glyph const *glyphs, int count, float scale ) = 0;
+		virtual void drawScreenLines( Vertex const *vertices, int count ) = 0;
+
+		// the last finished frame
+		virtual void readFrame( Image *image ) = 0;
+
+		// starts reading back the last finished frame and moves the oldest frame read back since into
+		// image, false if none has arrived yet; by default the frame is read back right away
+		virtual bool captureFrame( Image *image );
+
+		// waits for the frames still being read back, false once there are none left
+		virtual bool finishCapture( Image *image );
+	};
+
+
+	// with the OpenGL context current; mesh geometry is uploaded once and every instance of a mesh
+	// type drawn in one instanced call, falling back to immediate mode on drivers without instancing
+	Renderer *createOpenGLRenderer();
+
+	// with an OpenGL 3.3 core context current; shaders, vertex array objects and a uniform buffer
+	// for the view, no fixed function state; null if the context cannot run it
+	Renderer *createCoreOpenGLRenderer();
+
+	// rasterizes on the CPU in parallel tiles, the same frame always gives the same pixels
+	Renderer *createSoftwareRenderer( int width, int height );
+
+	// .png if the path ends with it, binary .ppm otherwise
+	bool writeImage( Image const &image, char const *path );
+
+	// the number goes in front of the extension, frame.png becomes frame_000600.png
+	std::string numberedPath( char const *path, long long number );
+}
+
+
+//-------------------------------------------------------
+//	command buffer
+//-------------------------------------------------------
+
+namespace render
+{
+	// draw order between layers; within a layer commands are grouped by state
+	enum Layer
+	{
+		LAYER_SEA,
+		LAYER_MESHES,
+		LAYER_INTERFACE,
+		LAYER_HUD,
+		LAYER_COUNT
+	};
+
+
+	// records a frame's draws with sort keys so the renderer sees every state once; owns the recorded
+	// data, so each thread can record into a buffer of its own
+	class CommandBuffer
+	{
+	public:
+		void clear();
+
+		void drawParticles( Layer layer, Vertex const *particles, int count, float pointSize );
+		void drawMesh( Layer layer, MeshType type, Instance const &instance );
+		void drawLines( Layer layer, Vertex const *vertices, int count, float width );
+		void drawGlyphs( Layer layer, Glyph const *glyphs, int count, float scale );
+		void drawScreenLines( Layer layer, Vertex const *vertices, int count );
+
+		// sorts by layer, primitive, mesh type and size, then draws each run of equal state in one call
+		void execute( Renderer &renderer );
+
+		int commandCount() const { return ( int )commands.size(); }
+
+	private:
+		enum Primitive
+		{
+			PRIMITIVE_POINTS,
+			PRIMITIVE_MESHES,
+			PRIMITIVE_LINES,
+			PRIMITIVE_GLYPHS,
+			PRIMITIVE_SCREEN_LINES,
+		};
+
+		struct Command
+		{
+			std::uint64_t key;		// state in the high 40 bits, recording order in the low 24
+			Primitive primitive;
+			MeshType meshType;
+			float size;
+			int first;				// into vertices, instances or glyphs
+			int count;
+		};
+
+		void record( Layer layer, Primitive primitive, MeshType meshType, float size, int first, int count );
+		void flush( Renderer &renderer, Command const &command, int runCount );
+
+		std::vector< Command > commands;
+		std::vector< Vertex > vertices;
+		std::vector< Instance > instances;
+		std::vector< Glyph > glyphs;
+
+		// scratch for runs of several commands, kept to reuse their storage
+		std::vector< Vertex > runVertices;
+		std::vector< Instance > runInstances;
+		std::vector< Glyph > runGlyphs;
+	};
+}
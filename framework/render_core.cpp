@@ -0,0 +1,534 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "opengl.hpp"
+#include "render.hpp"
+#include "profiler.hpp"
+
+
+//-------------------------------------------------------
+//	shaders
+//-------------------------------------------------------
+
+namespace
+{
+	// one binding point holds the view of the draws in flight, world or screen
+	constexpr GLuint VIEW_BINDING = 0;
+
+	// clip space is position * scale + offset, which is all a 2D view needs
+	char const *const VIEW_BLOCK =
+		"#version 330 core\n"
+		"layout( std140 ) uniform View\n"
+		"{\n"
+		"	vec4 transform;		// scale in xy, offset in zw\n"
+		"};\n"
+		"vec4 toClip( vec2 position )\n"
+		"{\n"
+		"	return vec4( position * transform.xy + transform.zw, 0.0, 1.0 );\n"
+		"}\n";
+
+	char const *const MESH_VERTEX_SHADER =
+		"layout( location = 0 ) in vec2 position;\n"
+		"layout( location = 1 ) in vec3 color;\n"
+		"layout( location = 2 ) in vec3 instance;\n"
+		"out vec3 vertexColor;\n"
+		"void main()\n"
+		"{\n"
+		"	float c = cos( instance.z );\n"
+		"	float s = sin( instance.z );\n"
+		"	gl_Position = toClip( instance.xy + vec2( c * position.x - s * position.y, s * position.x + c * position.y ) );\n"
+		"	vertexColor = color;\n"
+		"}\n";
+
+	// particles, lines and screen lines
+	char const *const COLOR_VERTEX_SHADER =
+		"layout( location = 0 ) in vec2 position;\n"
+		"layout( location = 1 ) in vec3 color;\n"
+		"out vec3 vertexColor;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_Position = toClip( position );\n"
+		"	vertexColor = color;\n"
+		"}\n";
+
+	char const *const COLOR_FRAGMENT_SHADER =
+		"#version 330 core\n"
+		"in vec3 vertexColor;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	fragmentColor = vec4( vertexColor, 1.0 );\n"
+		"}\n";
+
+	char const *const GLYPH_VERTEX_SHADER =
+		"layout( location = 0 ) in vec2 position;\n"
+		"layout( location = 1 ) in vec3 color;\n"
+		"layout( location = 2 ) in vec2 atlasPosition;\n"
+		"out vec3 vertexColor;\n"
+		"out vec2 atlasCoordinate;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_Position = toClip( position );\n"
+		"	vertexColor = color;\n"
+		"	atlasCoordinate = atlasPosition;\n"
+		"}\n";
+
+	// the atlas coverage is in the red channel, the sampler stays on texture unit 0
+	char const *const GLYPH_FRAGMENT_SHADER =
+		"#version 330 core\n"
+		"uniform sampler2D atlas;\n"
+		"in vec3 vertexColor;\n"
+		"in vec2 atlasCoordinate;\n"
+		"out vec4 fragmentColor;\n"
+		"void main()\n"
+		"{\n"
+		"	fragmentColor = vec4( vertexColor, texture( atlas, atlasCoordinate ).r );\n"
+		"}\n";
+
+
+	GLuint compileShader( GLenum type, char const *prefix, char const *source )
+	{
+		char const *sources[] = { prefix, source };
+		GLuint shader = gl::CreateShader( type );
+		gl::ShaderSource( shader, 2, sources, nullptr );
+		gl::CompileShader( shader );
+
+		GLint compiled = GL_FALSE;
+		gl::GetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+		if ( compiled )
+			return shader;
+		gl::DeleteShader( shader );
+		return 0;
+	}
+
+
+	// the vertex shader gets the view block in front, its uniform block is bound to VIEW_BINDING
+	GLuint linkProgram( char const *vertexSource, char const *fragmentSource )
+	{
+		GLuint vertexShader = compileShader( GL_VERTEX_SHADER, VIEW_BLOCK, vertexSource );
+		GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER, "", fragmentSource );
+		GLuint program = 0;
+		if ( vertexShader && fragmentShader )
+		{
+			program = gl::CreateProgram();
+			gl::AttachShader( program, vertexShader );
+			gl::AttachShader( program, fragmentShader );
+			gl::LinkProgram( program );
+
+			GLint linked = GL_FALSE;
+			gl::GetProgramiv( program, GL_LINK_STATUS, &linked );
+			GLuint viewBlock = linked ? gl::GetUniformBlockIndex( program, "View" ) : GL_INVALID_INDEX;
+			if ( viewBlock != GL_INVALID_INDEX )
+			{
+				gl::UniformBlockBinding( program, viewBlock, VIEW_BINDING );
+			}
+			else
+			{
+				gl::DeleteProgram( program );
+				program = 0;
+			}
+		}
+
+		// the program keeps them alive while attached
+		if ( vertexShader )
+			gl::DeleteShader( vertexShader );
+		if ( fragmentShader )
+			gl::DeleteShader( fragmentShader );
+		return program;
+	}
+}
+
+
+//-------------------------------------------------------
+//	renderer
+//-------------------------------------------------------
+
+namespace
+{
+	class CoreOpenGLRenderer : public render::Renderer
+	{
+	public:
+		~CoreOpenGLRenderer() override;
+
+		// false if the context lacks a function or a program does not build
+		bool init();
+
+		void beginFrame( render::View const &view, render::Color clearColor ) override;
+		void endFrame() override;
+
+		void drawParticles( render::Vertex const *particles, int count, float pointSize ) override;
+		void drawMeshes( render::MeshType type, render::Instance const *instances, int count ) override;
+		void drawLines( render::Vertex const *vertices, int count, float width ) override;
+		void drawGlyphs( render::Glyph const *glyphs, int count, float scale ) override;
+		void drawScreenLines( render::Vertex const *vertices, int count ) override;
+
+		void readFrame( render::Image *image ) override;
+		bool captureFrame( render::Image *image ) override;
+		bool finishCapture( render::Image *image ) override;
+
+	private:
+		enum ViewSlot
+		{
+			VIEW_WORLD,
+			VIEW_SCREEN,
+			VIEW_SLOT_COUNT
+		};
+
+		// a corner of a glyph quad
+		struct GlyphVertex
+		{
+			float x;
+			float y;
+			float r;
+			float g;
+			float b;
+			float u;
+			float v;
+		};
+
+		// triangles followed by the outline in one static buffer per mesh type, with a vertex
+		// array object reading it next to the shared instance buffer
+		struct MeshBuffer
+		{
+			GLuint buffer;
+			GLuint vertexArray;
+			GLint triangleVertices;
+			GLint outlineVertices;
+		};
+
+		void uploadMesh( render::MeshType type );
+		void uploadGlyphAtlas();
+		void use( GLuint program, GLuint vertexArray, ViewSlot view, bool blended );
+		void drawVertices( GLenum mode, render::Vertex const *vertices, int count, ViewSlot view );
+
+		gl::StateCache state;
+
+		GLuint meshProgram = 0;
+		GLuint colorProgram = 0;
+		GLuint glyphProgram = 0;
+
+		MeshBuffer meshBuffers[ render::MESH_TYPE_COUNT ] = {};
+		GLuint instanceBuffer = 0;
+
+		// particles and lines are streamed through one buffer, glyph quads through another
+		GLuint vertexBuffer = 0;
+		GLuint vertexArray = 0;
+		GLuint glyphBuffer = 0;
+		GLuint glyphArray = 0;
+		GLuint glyphTexture = 0;
+		std::vector< GlyphVertex > glyphVertices;
+
+		// the world and screen view transforms, each in its own aligned range
+		GLuint viewBuffer = 0;
+		std::ptrdiff_t viewStride = 0;
+		std::vector< unsigned char > viewData;
+		int boundView = -1;
+
+		std::unique_ptr< gl::FrameReader > frameReader;
+	};
+
+
+	//-------------------------------------------------------
+	void *bufferOffset( std::size_t offset )
+	{
+		return reinterpret_cast< void* >( static_cast< std::uintptr_t >( offset ) );
+	}
+
+
+	//-------------------------------------------------------
+	bool CoreOpenGLRenderer::init()
+	{
+		if ( !gl::loadCoreFunctions() )
+			return false;
+		meshProgram = linkProgram( MESH_VERTEX_SHADER, COLOR_FRAGMENT_SHADER );
+		colorProgram = linkProgram( COLOR_VERTEX_SHADER, COLOR_FRAGMENT_SHADER );
+		glyphProgram = linkProgram( GLYPH_VERTEX_SHADER, GLYPH_FRAGMENT_SHADER );
+		if ( !meshProgram || !colorProgram || !glyphProgram )
+			return false;
+
+		gl::GenBuffers( 1, &instanceBuffer );
+		for ( int type = 0; type < render::MESH_TYPE_COUNT; ++type )
+			uploadMesh( ( render::MeshType )type );
+
+		gl::GenBuffers( 1, &vertexBuffer );
+		gl::GenVertexArrays( 1, &vertexArray );
+		state.bindVertexArray( vertexArray );
+		state.bindArrayBuffer( vertexBuffer );
+		gl::EnableVertexAttribArray( 0 );
+		gl::VertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( render::Vertex ), bufferOffset( offsetof( render::Vertex, x ) ) );
+		gl::EnableVertexAttribArray( 1 );
+		gl::VertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, sizeof( render::Vertex ), bufferOffset( offsetof( render::Vertex, r ) ) );
+
+		gl::GenBuffers( 1, &glyphBuffer );
+		gl::GenVertexArrays( 1, &glyphArray );
+		state.bindVertexArray( glyphArray );
+		state.bindArrayBuffer( glyphBuffer );
+		gl::EnableVertexAttribArray( 0 );
+		gl::VertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( GlyphVertex ), bufferOffset( offsetof( GlyphVertex, x ) ) );
+		gl::EnableVertexAttribArray( 1 );
+		gl::VertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, sizeof( GlyphVertex ), bufferOffset( offsetof( GlyphVertex, r ) ) );
+		gl::EnableVertexAttribArray( 2 );
+		gl::VertexAttribPointer( 2, 2, GL_FLOAT, GL_FALSE, sizeof( GlyphVertex ), bufferOffset( offsetof( GlyphVertex, u ) ) );
+		uploadGlyphAtlas();
+
+		// ranges bound to a uniform block must start at a multiple of the alignment
+		GLint alignment = 0;
+		glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment );
+		viewStride = std::max< std::ptrdiff_t >( alignment, 4 * sizeof( float ) );
+		gl::GenBuffers( 1, &viewBuffer );
+		viewData.resize( viewStride * VIEW_SLOT_COUNT );
+
+		frameReader.reset( new gl::FrameReader );
+		return true;
+	}
+
+
+	//-------------------------------------------------------
+	CoreOpenGLRenderer::~CoreOpenGLRenderer()
+	{
+		// after a failed init() whatever was made goes away with the context
+		if ( !frameReader )
+			return;
+		frameReader.reset();
+		for ( MeshBuffer &mesh : meshBuffers )
+		{
+			gl::DeleteVertexArrays( 1, &mesh.vertexArray );
+			gl::DeleteBuffers( 1, &mesh.buffer );
+		}
+		gl::DeleteBuffers( 1, &instanceBuffer );
+		gl::DeleteVertexArrays( 1, &vertexArray );
+		gl::DeleteBuffers( 1, &vertexBuffer );
+		gl::DeleteVertexArrays( 1, &glyphArray );
+		gl::DeleteBuffers( 1, &glyphBuffer );
+		gl::DeleteBuffers( 1, &viewBuffer );
+		glDeleteTextures( 1, &glyphTexture );
+		gl::DeleteProgram( meshProgram );
+		gl::DeleteProgram( colorProgram );
+		gl::DeleteProgram( glyphProgram );
+	}
+
+
+	//-------------------------------------------------------
+	void CoreOpenGLRenderer::uploadMesh( render::MeshType type )
+	{
+		render::MeshGeometry const &geometry = render::meshGeometry( type );
+		std::vector< render::Vertex > vertices( geometry.triangles );
+		vertices.insert( vertices.end(), geometry.outline.begin(), geometry.outline.end() );
+
+		MeshBuffer &mesh = meshBuffers[ type ];
+		mesh.triangleVertices = ( GLint )geometry.triangles.size();
+		mesh.outlineVertices = ( GLint )geometry.outline.size();
+		gl::GenBuffers( 1, &mesh.buffer );
+		gl::GenVertexArrays( 1, &mesh.vertexArray );
+		state.bindVertexArray( mesh.vertexArray );
+
+		state.bindArrayBuffer( mesh.buffer );
+		gl::BufferData( GL_ARRAY_BUFFER, vertices.size() * sizeof( render::Vertex ), vertices.data(), GL_STATIC_DRAW );
+		gl::EnableVertexAttribArray( 0 );
+		gl::VertexAttribPointer( 0, 2, GL_FLOAT, GL_FALSE, sizeof( render::Vertex ), bufferOffset( offsetof( render::Vertex, x ) ) );
+		gl::EnableVertexAttribArray( 1 );
+		gl::VertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, sizeof( render::Vertex ), bufferOffset( offsetof( render::Vertex, r ) ) );
+
+		state.bindArrayBuffer( instanceBuffer );
+		gl::EnableVertexAttribArray( 2 );
+		gl::VertexAttribPointer( 2, 3, GL_FLOAT, GL_FALSE, sizeof( render::Instance ), bufferOffset( 0 ) );
+		gl::VertexAttribDivisor( 2, 1 );
+	}
+
+
+	//-------------------------------------------------------
+	// core contexts have no alpha textures, the coverage goes into a single red channel
+	void CoreOpenGLRenderer::uploadGlyphAtlas()
+	{
+		render::GlyphAtlas const &atlas = render::glyphAtlas();
+		glGenTextures( 1, &glyphTexture );
+		state.bindTexture( glyphTexture );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+		glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+		glTexImage2D( GL_TEXTURE_2D, 0, GL_R8, atlas.width, atlas.height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.coverage.data() );
+
+		// only the glyphs enable blending, the function never changes
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+	}
+
+
+	//-------------------------------------------------------
+	void CoreOpenGLRenderer::beginFrame( render::View const &view, render::Color clearColor )
+	{
+		GLint viewport[ 4 ];
+		glGetIntegerv( GL_VIEWPORT, viewport );
+
+		// screen space is pixels from the top left corner with y growing downwards
+		float const world[ 4 ] = { 2.f / view.width, 2.f / view.height, -2.f * view.centerX / view.width, -2.f * view.centerY / view.height };
+		float const screen[ 4 ] = { 2.f / viewport[ 2 ], -2.f / viewport[ 3 ], -1.f, 1.f };
+		std::memcpy( &viewData[ VIEW_WORLD * viewStride ], world, sizeof( world ) );
+		std::memcpy( &viewData[ VIEW_SCREEN * viewStride ], screen, sizeof( screen ) );
+		gl::BindBuffer( GL_UNIFORM_BUFFER, viewBuffer );
+		gl::BufferData( GL_UNIFORM_BUFFER, ( std::ptrdiff_t )viewData.size(), viewData.data(), GL_STREAM_DRAW );
+		boundView = -1;
+
+		state.capability( GL_CULL_FACE, false );
+		state.clearColor( clearColor.r, clearColor.g, clearColor.b, 0.f );
+		glClear( GL_COLOR_BUFFER_BIT );
+	}
+
+
+	//-------------------------------------------------------
+	void CoreOpenGLRenderer::endFrame()
+	{
+		int changes, filtered;
+		state.takeCounts( &changes, &filtered );
+		profiler::addCount( profiler::COUNTER_GL_STATE_CHANGES, changes );
+		profiler::addCount( profiler::COUNTER_GL_STATE_CHANGES_FILTERED, filtered );
+	}
+
+
+	//-------------------------------------------------------
+	void CoreOpenGLRenderer::use( GLuint program, GLuint array, ViewSlot view, bool blended )
+	{
+		state.useProgram( program );
+		state.bindVertexArray( array );
+		state.capability( GL_BLEND, blended );
+		if ( boundView != view )
+		{
+			gl::BindBufferRange( GL_UNIFORM_BUFFER, VIEW_BINDING, viewBuffer, view * viewStride, 4 * sizeof( float ) );
+			boundView = view;
+		}
+	}
+
+
+	//-------------------------------------------------------
+	// streamed, orphaning the old storage keeps the driver from waiting on draws still reading it
+	void CoreOpenGLRenderer::drawVertices( GLenum mode, render::Vertex const *vertices, int count, ViewSlot view )
+	{
+		use( colorProgram, vertexArray, view, false );
+		state.bindArrayBuffer( vertexBuffer );
+		gl::BufferData( GL_ARRAY_BUFFER, count * sizeof( render::Vertex ), vertices, GL_STREAM_DRAW );
+		glDrawArrays( mode, 0, count );
+	}
+
+
+	//-------------------------------------------------------
+	void CoreOpenGLRenderer::drawParticles( render::Vertex const *particles, int count, float pointSize )
+	{
+		if ( count == 0 )
+			return;
+		state.pointSize( pointSize );
+		drawVertices( GL_POINTS, particles, count, VIEW_WORLD );
+	}
+
+
+	//-------------------------------------------------------
+	void CoreOpenGLRenderer::drawMeshes( render::MeshType type, render::Instance const *instances, int count )
+	{
+		assert( type >= 0 && type < render::MESH_TYPE_COUNT );
+		if ( count == 0 )
+			return;
+
+		MeshBuffer const &mesh = meshBuffers[ type ];
+		use( meshProgram, mesh.vertexArray, VIEW_WORLD, false );
+		state.bindArrayBuffer( instanceBuffer );
+		gl::BufferData( GL_ARRAY_BUFFER, count * sizeof( render::Instance ), instances, GL_STREAM_DRAW );
+		gl::DrawArraysInstanced( GL_TRIANGLES, 0, mesh.triangleVertices, count );
+
+		// wide lines are deprecated but still core outside of forward compatible contexts
+		state.lineWidth( render::meshGeometry( type ).outlineWidth );
+		gl::DrawArraysInstanced( GL_LINE_LOOP, mesh.triangleVertices, mesh.outlineVertices, count );
+	}
+
+
+	//-------------------------------------------------------
+	void CoreOpenGLRenderer::drawLines( render::Vertex const *vertices, int count, float width )
+	{
+		if ( count == 0 )
+			return;
+		state.lineWidth( width );
+		drawVertices( GL_LINES, vertices, count, VIEW_WORLD );
+	}
+
+
+	//-------------------------------------------------------
+	void CoreOpenGLRenderer::drawScreenLines( render::Vertex const *vertices, int count )
+	{
+		if ( count == 0 )
+			return;
+		state.lineWidth( 1.f );
+		drawVertices( GL_LINES, vertices, count, VIEW_SCREEN );
+	}
+
+
+	//-------------------------------------------------------
+	// two triangles per glyph, there are no quads in a core context
+	void CoreOpenGLRenderer::drawGlyphs( render::Glyph const *glyphs, int count, float scale )
+	{
+		render::GlyphAtlas const &atlas = render::glyphAtlas();
+		float cellWidth = render::GLYPH_WIDTH * scale;
+		float cellHeight = render::GLYPH_HEIGHT * scale;
+		float cellU = ( float )render::GLYPH_WIDTH / atlas.width;
+		float cellV = ( float )render::GLYPH_HEIGHT / atlas.height;
+
+		glyphVertices.clear();
+		for ( int i = 0; i < count; ++i )
+		{
+			render::Glyph const &glyph = glyphs[ i ];
+			int atlasX, atlasY;
+			if ( !render::glyphCell( glyph.character, &atlasX, &atlasY ) )
+				continue;
+			float u = ( float )atlasX / atlas.width;
+			float v = ( float )atlasY / atlas.height;
+			render::Color color = glyph.color;
+			GlyphVertex topLeft = { glyph.x, glyph.y, color.r, color.g, color.b, u, v };
+			GlyphVertex topRight = { glyph.x + cellWidth, glyph.y, color.r, color.g, color.b, u + cellU, v };
+			GlyphVertex bottomRight = { glyph.x + cellWidth, glyph.y + cellHeight, color.r, color.g, color.b, u + cellU, v + cellV };
+			GlyphVertex bottomLeft = { glyph.x, glyph.y + cellHeight, color.r, color.g, color.b, u, v + cellV };
+			glyphVertices.insert( glyphVertices.end(), { topLeft, topRight, bottomRight, topLeft, bottomRight, bottomLeft } );
+		}
+		if ( glyphVertices.empty() )
+			return;
+
+		use( glyphProgram, glyphArray, VIEW_SCREEN, true );
+		state.bindTexture( glyphTexture );
+		state.bindArrayBuffer( glyphBuffer );
+		gl::BufferData( GL_ARRAY_BUFFER, glyphVertices.size() * sizeof( GlyphVertex ), glyphVertices.data(), GL_STREAM_DRAW );
+		glDrawArrays( GL_TRIANGLES, 0, ( GLsizei )glyphVertices.size() );
+	}
+
+
+	//-------------------------------------------------------
+	void CoreOpenGLRenderer::readFrame( render::Image *image )
+	{
+		gl::FrameReader::readFrame( image );
+	}
+
+
+	//-------------------------------------------------------
+	bool CoreOpenGLRenderer::captureFrame( render::Image *image )
+	{
+		return frameReader->captureFrame( image );
+	}
+
+
+	//-------------------------------------------------------
+	bool CoreOpenGLRenderer::finishCapture( render::Image *image )
+	{
+		return frameReader->finishCapture( image );
+	}
+}
+
+
+namespace render
+{
+	Renderer *createCoreOpenGLRenderer()
+	{
+		CoreOpenGLRenderer *renderer = new CoreOpenGLRenderer;
+		if ( renderer->init() )
+			return renderer;
+		delete renderer;
+		return nullptr;
+	}
+}
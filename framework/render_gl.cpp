@@ -0,0 +1,507 @@
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+
+#include "opengl.hpp"
+#include "render.hpp"
+#include "profiler.hpp"
+
+
+//-------------------------------------------------------
+//	shaders
+//-------------------------------------------------------
+
+namespace
+{
+	enum Attribute
+	{
+		ATTRIBUTE_POSITION,
+		ATTRIBUTE_COLOR,
+		ATTRIBUTE_INSTANCE,
+	};
+
+
+	// GLSL 1.20 runs on any context new enough for instancing, the projection
+	// still comes from the fixed function matrix stack the rest of the scene uses
+	char const *const VERTEX_SHADER =
+		"#version 120\n"
+		"attribute vec2 position;\n"
+		"attribute vec3 color;\n"
+		"attribute vec3 instance;\n"
+		"varying vec3 vertexColor;\n"
+		"void main()\n"
+		"{\n"
+		"	float c = cos( instance.z );\n"
+		"	float s = sin( instance.z );\n"
+		"	vec2 world = instance.xy + vec2( c * position.x - s * position.y, s * position.x + c * position.y );\n"
+		"	gl_Position = gl_ModelViewProjectionMatrix * vec4( world, 0.0, 1.0 );\n"
+		"	vertexColor = color;\n"
+		"}\n";
+
+	char const *const FRAGMENT_SHADER =
+		"#version 120\n"
+		"varying vec3 vertexColor;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_FragColor = vec4( vertexColor, 1.0 );\n"
+		"}\n";
+
+
+	GLuint compileShader( GLenum type, char const *source )
+	{
+		GLuint shader = gl::CreateShader( type );
+		gl::ShaderSource( shader, 1, &source, nullptr );
+		gl::CompileShader( shader );
+
+		GLint compiled = GL_FALSE;
+		gl::GetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+		if ( compiled )
+			return shader;
+		gl::DeleteShader( shader );
+		return 0;
+	}
+
+
+	GLuint linkProgram()
+	{
+		GLuint vertexShader = compileShader( GL_VERTEX_SHADER, VERTEX_SHADER );
+		GLuint fragmentShader = compileShader( GL_FRAGMENT_SHADER, FRAGMENT_SHADER );
+		GLuint program = 0;
+		if ( vertexShader && fragmentShader )
+		{
+			program = gl::CreateProgram();
+			gl::AttachShader( program, vertexShader );
+			gl::AttachShader( program, fragmentShader );
+			gl::BindAttribLocation( program, ATTRIBUTE_POSITION, "position" );
+			gl::BindAttribLocation( program, ATTRIBUTE_COLOR, "color" );
+			gl::BindAttribLocation( program, ATTRIBUTE_INSTANCE, "instance" );
+			gl::LinkProgram( program );
+
+			GLint linked = GL_FALSE;
+			gl::GetProgramiv( program, GL_LINK_STATUS, &linked );
+			if ( !linked )
+			{
+				gl::DeleteProgram( program );
+				program = 0;
+			}
+		}
+
+		// the program keeps them alive while attached
+		if ( vertexShader )
+			gl::DeleteShader( vertexShader );
+		if ( fragmentShader )
+			gl::DeleteShader( fragmentShader );
+		return program;
+	}
+}
+
+
+//-------------------------------------------------------
+//	renderer
+//-------------------------------------------------------
+
+namespace
+{
+	class OpenGLRenderer : public render::Renderer
+	{
+	public:
+		OpenGLRenderer();
+		~OpenGLRenderer() override;
+
+		void beginFrame( render::View const &view, render::Color clearColor ) override;
+		void endFrame() override;
+
+		void drawParticles( render::Vertex const *particles, int count, float pointSize ) override;
+		void drawMeshes( render::MeshType type, render::Instance const *instances, int count ) override;
+		void drawLines( render::Vertex const *vertices, int count, float width ) override;
+		void drawGlyphs( render::Glyph const *glyphs, int count, float scale ) override;
+		void drawScreenLines( render::Vertex const *vertices, int count ) override;
+
+		void readFrame( render::Image *image ) override;
+		bool captureFrame( render::Image *image ) override;
+		bool finishCapture( render::Image *image ) override;
+
+	private:
+		// triangles followed by the outline in one static buffer per mesh type
+		struct MeshBuffer
+		{
+			GLuint buffer;
+			GLint triangleVertices;
+			GLint outlineVertices;
+		};
+
+		// a corner of a glyph quad
+		struct GlyphVertex
+		{
+			float x;
+			float y;
+			float u;
+			float v;
+			float r;
+			float g;
+			float b;
+		};
+
+		void uploadMesh( render::MeshType type );
+		void uploadGlyphAtlas();
+		void useFixedFunction( bool textured );
+		void useScreenView();
+		void drawImmediate( render::MeshType type, render::Instance const *instances, int count );
+
+		// the scene sets the same few states every frame, most of them filtered here
+		gl::StateCache state;
+
+		// buffers, the mesh program and instancing are all available
+		bool retained = false;
+		GLuint meshProgram = 0;
+		MeshBuffer meshBuffers[ render::MESH_TYPE_COUNT ] = {};
+		GLuint instanceBuffer = 0;
+		GLuint particleBuffer = 0;
+
+		// glyphs are alpha blended quads textured from the atlas, built into scratch every frame
+		GLuint glyphTexture = 0;
+		std::vector< GlyphVertex > glyphVertices;
+
+		// viewport size as of beginFrame(), for the screen space draws
+		int screenWidth = 0;
+		int screenHeight = 0;
+
+		// only with buffer objects, otherwise frames are read back right away
+		std::unique_ptr< gl::FrameReader > frameReader;
+	};
+
+
+	//-------------------------------------------------------
+	void *bufferOffset( std::size_t offset )
+	{
+		return reinterpret_cast< void* >( static_cast< std::uintptr_t >( offset ) );
+	}
+
+
+	//-------------------------------------------------------
+	OpenGLRenderer::OpenGLRenderer()
+	{
+		uploadGlyphAtlas();
+		retained = gl::loadFunctions() && ( meshProgram = linkProgram() ) != 0;
+		if ( !retained )
+			return;
+
+		for ( int type = 0; type < render::MESH_TYPE_COUNT; ++type )
+			uploadMesh( ( render::MeshType )type );
+		gl::GenBuffers( 1, &instanceBuffer );
+		gl::GenBuffers( 1, &particleBuffer );
+		frameReader.reset( new gl::FrameReader );
+	}
+
+
+	//-------------------------------------------------------
+	OpenGLRenderer::~OpenGLRenderer()
+	{
+		glDeleteTextures( 1, &glyphTexture );
+		if ( !retained )
+			return;
+
+		for ( MeshBuffer &mesh : meshBuffers )
+			gl::DeleteBuffers( 1, &mesh.buffer );
+		gl::DeleteBuffers( 1, &instanceBuffer );
+		gl::DeleteBuffers( 1, &particleBuffer );
+		frameReader.reset();
+		gl::DeleteProgram( meshProgram );
+	}
+
+
+	//-------------------------------------------------------
+	void OpenGLRenderer::uploadMesh( render::MeshType type )
+	{
+		render::MeshGeometry const &geometry = render::meshGeometry( type );
+		std::vector< render::Vertex > vertices( geometry.triangles );
+		vertices.insert( vertices.end(), geometry.outline.begin(), geometry.outline.end() );
+
+		MeshBuffer &mesh = meshBuffers[ type ];
+		mesh.triangleVertices = ( GLint )geometry.triangles.size();
+		mesh.outlineVertices = ( GLint )geometry.outline.size();
+		gl::GenBuffers( 1, &mesh.buffer );
+		state.bindArrayBuffer( mesh.buffer );
+		gl::BufferData( GL_ARRAY_BUFFER, vertices.size() * sizeof( render::Vertex ), vertices.data(), GL_STATIC_DRAW );
+	}
+
+
+	//-------------------------------------------------------
+	// textures are core since OpenGL 1.1, the glyphs need no extension
+	void OpenGLRenderer::uploadGlyphAtlas()
+	{
+		render::GlyphAtlas const &atlas = render::glyphAtlas();
+		glGenTextures( 1, &glyphTexture );
+		state.bindTexture( glyphTexture );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+		glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+		glTexImage2D( GL_TEXTURE_2D, 0, GL_ALPHA, atlas.width, atlas.height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, atlas.coverage.data() );
+
+		// only the glyphs enable blending, the function never changes
+		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+	}
+
+
+	//-------------------------------------------------------
+	void OpenGLRenderer::beginFrame( render::View const &view, render::Color clearColor )
+	{
+		GLint viewport[ 4 ];
+		glGetIntegerv( GL_VIEWPORT, viewport );
+		screenWidth = viewport[ 2 ];
+		screenHeight = viewport[ 3 ];
+
+		state.view( view.centerX, view.centerY, view.width, view.height );
+		state.capability( GL_CULL_FACE, false );
+		state.clearColor( clearColor.r, clearColor.g, clearColor.b, 0.f );
+		glClear( GL_COLOR_BUFFER_BIT );
+	}
+
+
+	//-------------------------------------------------------
+	void OpenGLRenderer::endFrame()
+	{
+		int changes, filtered;
+		state.takeCounts( &changes, &filtered );
+		profiler::addCount( profiler::COUNTER_GL_STATE_CHANGES, changes );
+		profiler::addCount( profiler::COUNTER_GL_STATE_CHANGES_FILTERED, filtered );
+	}
+
+
+	//-------------------------------------------------------
+	// fixed function arrays and the mesh program's generic ones must not be enabled together,
+	// and a texture coordinate array left enabled would be read from memory long gone
+	void OpenGLRenderer::useFixedFunction( bool textured )
+	{
+		state.capability( GL_TEXTURE_2D, textured );
+		state.capability( GL_BLEND, textured );
+		state.clientState( GL_TEXTURE_COORD_ARRAY, textured );
+		if ( !retained )
+			return;
+		state.useProgram( 0 );
+		state.vertexAttribArray( ATTRIBUTE_POSITION, false );
+		state.vertexAttribArray( ATTRIBUTE_COLOR, false );
+		state.vertexAttribArray( ATTRIBUTE_INSTANCE, false );
+	}
+
+
+	//-------------------------------------------------------
+	// pixels from the top left corner, y grows downwards
+	void OpenGLRenderer::useScreenView()
+	{
+		state.view( screenWidth * 0.5f, screenHeight * 0.5f, ( float )screenWidth, -( float )screenHeight );
+		state.modelviewIdentity();
+	}
+
+
+	//-------------------------------------------------------
+	void OpenGLRenderer::drawParticles( render::Vertex const *particles, int count, float pointSize )
+	{
+		if ( count == 0 )
+			return;
+
+		// without buffer objects the same arrays are read from client memory, still in one call
+		char const *vertices = reinterpret_cast< char const* >( particles );
+		useFixedFunction( false );
+		if ( retained )
+		{
+			state.bindArrayBuffer( particleBuffer );
+			gl::BufferData( GL_ARRAY_BUFFER, count * sizeof( render::Vertex ), particles, GL_STREAM_DRAW );
+			vertices = nullptr;
+		}
+
+		state.modelviewIdentity();
+		state.pointSize( pointSize );
+		state.clientState( GL_VERTEX_ARRAY, true );
+		state.clientState( GL_COLOR_ARRAY, true );
+		glVertexPointer( 2, GL_FLOAT, sizeof( render::Vertex ), vertices + offsetof( render::Vertex, x ) );
+		glColorPointer( 3, GL_FLOAT, sizeof( render::Vertex ), vertices + offsetof( render::Vertex, r ) );
+		glDrawArrays( GL_POINTS, 0, count );
+	}
+
+
+	//-------------------------------------------------------
+	void OpenGLRenderer::drawMeshes( render::MeshType type, render::Instance const *instances, int count )
+	{
+		assert( type >= 0 && type < render::MESH_TYPE_COUNT );
+		if ( count == 0 )
+			return;
+		if ( !retained )
+		{
+			drawImmediate( type, instances, count );
+			return;
+		}
+
+		state.clientState( GL_VERTEX_ARRAY, false );
+		state.clientState( GL_COLOR_ARRAY, false );
+		state.clientState( GL_TEXTURE_COORD_ARRAY, false );
+
+		// instance data changes every frame, orphaning the old storage keeps the driver from waiting on it
+		state.bindArrayBuffer( instanceBuffer );
+		gl::BufferData( GL_ARRAY_BUFFER, count * sizeof( render::Instance ), instances, GL_STREAM_DRAW );
+		state.vertexAttribArray( ATTRIBUTE_INSTANCE, true );
+		gl::VertexAttribPointer( ATTRIBUTE_INSTANCE, 3, GL_FLOAT, GL_FALSE, sizeof( render::Instance ), bufferOffset( 0 ) );
+		state.vertexAttribDivisor( ATTRIBUTE_INSTANCE, 1 );
+
+		MeshBuffer const &mesh = meshBuffers[ type ];
+		state.bindArrayBuffer( mesh.buffer );
+		state.vertexAttribArray( ATTRIBUTE_POSITION, true );
+		gl::VertexAttribPointer( ATTRIBUTE_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof( render::Vertex ), bufferOffset( offsetof( render::Vertex, x ) ) );
+		state.vertexAttribArray( ATTRIBUTE_COLOR, true );
+		gl::VertexAttribPointer( ATTRIBUTE_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof( render::Vertex ), bufferOffset( offsetof( render::Vertex, r ) ) );
+
+		// instances are placed by the shader, the modelview matrix must not move them again
+		state.modelviewIdentity();
+		state.useProgram( meshProgram );
+		gl::DrawArraysInstanced( GL_TRIANGLES, 0, mesh.triangleVertices, count );
+		state.lineWidth( render::meshGeometry( type ).outlineWidth );
+		gl::DrawArraysInstanced( GL_LINE_LOOP, mesh.triangleVertices, mesh.outlineVertices, count );
+	}
+
+
+	//-------------------------------------------------------
+	// one glBegin/glEnd pair per primitive and instance, for drivers without instancing
+	void OpenGLRenderer::drawImmediate( render::MeshType type, render::Instance const *instances, int count )
+	{
+		render::MeshGeometry const &geometry = render::meshGeometry( type );
+		useFixedFunction( false );
+		state.lineWidth( geometry.outlineWidth );
+		for ( int i = 0; i < count; ++i )
+		{
+			state.modelviewIdentity();
+			glTranslatef( instances[ i ].x, instances[ i ].y, 0.f );
+			glRotatef( instances[ i ].angle * 180.f / 3.14159265f, 0.f, 0.f, 1.f );
+			state.modelviewChanged();
+
+			glBegin( GL_TRIANGLES );
+			for ( render::Vertex const &vertex : geometry.triangles )
+			{
+				glColor3f( vertex.r, vertex.g, vertex.b );
+				glVertex2f( vertex.x, vertex.y );
+			}
+			glEnd();
+
+			glBegin( GL_LINE_LOOP );
+			for ( render::Vertex const &vertex : geometry.outline )
+			{
+				glColor3f( vertex.r, vertex.g, vertex.b );
+				glVertex2f( vertex.x, vertex.y );
+			}
+			glEnd();
+		}
+	}
+
+
+	//-------------------------------------------------------
+	void OpenGLRenderer::drawLines( render::Vertex const *vertices, int count, float width )
+	{
+		useFixedFunction( false );
+		state.modelviewIdentity();
+		state.lineWidth( width );
+		glBegin( GL_LINES );
+		for ( int i = 0; i < count; ++i )
+		{
+			glColor3f( vertices[ i ].r, vertices[ i ].g, vertices[ i ].b );
+			glVertex2f( vertices[ i ].x, vertices[ i ].y );
+		}
+		glEnd();
+	}
+
+
+	//-------------------------------------------------------
+	// a quad per glyph, all of them in one call from client memory
+	void OpenGLRenderer::drawGlyphs( render::Glyph const *glyphs, int count, float scale )
+	{
+		render::GlyphAtlas const &atlas = render::glyphAtlas();
+		float cellWidth = render::GLYPH_WIDTH * scale;
+		float cellHeight = render::GLYPH_HEIGHT * scale;
+		float cellU = ( float )render::GLYPH_WIDTH / atlas.width;
+		float cellV = ( float )render::GLYPH_HEIGHT / atlas.height;
+
+		glyphVertices.clear();
+		for ( int i = 0; i < count; ++i )
+		{
+			render::Glyph const &glyph = glyphs[ i ];
+			int atlasX, atlasY;
+			if ( !render::glyphCell( glyph.character, &atlasX, &atlasY ) )
+				continue;
+			float u = ( float )atlasX / atlas.width;
+			float v = ( float )atlasY / atlas.height;
+			render::Color color = glyph.color;
+			glyphVertices.push_back( GlyphVertex{ glyph.x, glyph.y, u, v, color.r, color.g, color.b } );
+			glyphVertices.push_back( GlyphVertex{ glyph.x + cellWidth, glyph.y, u + cellU, v, color.r, color.g, color.b } );
+			glyphVertices.push_back( GlyphVertex{ glyph.x + cellWidth, glyph.y + cellHeight, u + cellU, v + cellV, color.r, color.g, color.b } );
+			glyphVertices.push_back( GlyphVertex{ glyph.x, glyph.y + cellHeight, u, v + cellV, color.r, color.g, color.b } );
+		}
+		if ( glyphVertices.empty() )
+			return;
+
+		useFixedFunction( true );
+		if ( retained )
+			state.bindArrayBuffer( 0 );
+		useScreenView();
+		state.bindTexture( glyphTexture );
+		state.clientState( GL_VERTEX_ARRAY, true );
+		state.clientState( GL_COLOR_ARRAY, true );
+		char const *vertices = reinterpret_cast< char const* >( glyphVertices.data() );
+		glVertexPointer( 2, GL_FLOAT, sizeof( GlyphVertex ), vertices + offsetof( GlyphVertex, x ) );
+		glTexCoordPointer( 2, GL_FLOAT, sizeof( GlyphVertex ), vertices + offsetof( GlyphVertex, u ) );
+		glColorPointer( 3, GL_FLOAT, sizeof( GlyphVertex ), vertices + offsetof( GlyphVertex, r ) );
+		glDrawArrays( GL_QUADS, 0, ( GLsizei )glyphVertices.size() );
+	}
+
+
+	//-------------------------------------------------------
+	void OpenGLRenderer::drawScreenLines( render::Vertex const *vertices, int count )
+	{
+		if ( count == 0 )
+			return;
+
+		useFixedFunction( false );
+		if ( retained )
+			state.bindArrayBuffer( 0 );
+		useScreenView();
+		state.lineWidth( 1.f );
+		state.clientState( GL_VERTEX_ARRAY, true );
+		state.clientState( GL_COLOR_ARRAY, true );
+		char const *data = reinterpret_cast< char const* >( vertices );
+		glVertexPointer( 2, GL_FLOAT, sizeof( render::Vertex ), data + offsetof( render::Vertex, x ) );
+		glColorPointer( 3, GL_FLOAT, sizeof( render::Vertex ), data + offsetof( render::Vertex, r ) );
+		glDrawArrays( GL_LINES, 0, count );
+	}
+
+
+	//-------------------------------------------------------
+	void OpenGLRenderer::readFrame( render::Image *image )
+	{
+		gl::FrameReader::readFrame( image );
+	}
+
+
+	//-------------------------------------------------------
+	bool OpenGLRenderer::captureFrame( render::Image *image )
+	{
+		if ( !retained )
+			return Renderer::captureFrame( image );
+		return frameReader->captureFrame( image );
+	}
+
+
+	//-------------------------------------------------------
+	bool OpenGLRenderer::finishCapture( render::Image *image )
+	{
+		if ( !retained )
+			return false;
+		return frameReader->finishCapture( image );
+	}
+}
+
+
+namespace render
+{
+	Renderer *createOpenGLRenderer()
+	{
+		return new OpenGLRenderer;
+	}
+}
@@ -0,0 +1,443 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SOFTWARE_RENDERER_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "render.hpp"
+#include "jobs.hpp"
+#include "profiler.hpp"
+
+
+//-------------------------------------------------------
+//	triangle setup
+//-------------------------------------------------------
+
+namespace
+{
+	// the framebuffer is split into square tiles rasterized in parallel; a multiple of 4 wide,
+	// so every row of a tile starts on a whole group of 4 pixels
+	constexpr int TILE_SIZE = 64;
+
+
+	struct Point
+	{
+		float x;
+		float y;
+	};
+
+
+	// edge function a * x + b * y + c, non-negative on the inner side
+	struct Edge
+	{
+		float a;
+		float b;
+		float c;
+	};
+
+
+	// in pixels, flat shaded like every primitive the scene draws
+	struct Triangle
+	{
+		Edge edges[ 3 ];
+		int minX, minY, maxX, maxY;		// inclusive pixel bounds, clipped to the framebuffer
+		std::uint32_t color;
+	};
+
+
+	Edge edgeBetween( Point from, Point to )
+	{
+		return Edge{ from.y - to.y, to.x - from.x, from.x * to.y - from.y * to.x };
+	}
+
+
+	std::uint32_t packColor( float r, float g, float b )
+	{
+		auto channel = []( float value ) { return ( std::uint32_t )( std::min( std::max( value, 0.f ), 1.f ) * 255.f + 0.5f ); };
+		return channel( r ) | channel( g ) << 8 | channel( b ) << 16;
+	}
+}
+
+
+//-------------------------------------------------------
+//	rasterization
+//-------------------------------------------------------
+
+namespace
+{
+	// pixels are covered when their center is on the inner side of all three edges
+	void rasterize( Triangle const &triangle, int tileX, int tileY, std::uint32_t *pixels, int stride )
+	{
+		int minX = std::max( triangle.minX, tileX ) & ~3;
+		int maxX = std::min( triangle.maxX, tileX + TILE_SIZE - 1 );
+		int minY = std::max( triangle.minY, tileY );
+		int maxY = std::min( triangle.maxY, tileY + TILE_SIZE - 1 );
+		Edge const *edges = triangle.edges;
+
+#ifdef SOFTWARE_RENDERER_SSE2
+		__m128 const lanes = _mm_setr_ps( 0.f, 1.f, 2.f, 3.f );
+		__m128 const zero = _mm_setzero_ps();
+		__m128i const color = _mm_set1_epi32( ( int )triangle.color );
+		__m128 step[ 3 ];
+		__m128 laneOffset[ 3 ];
+		for ( int i = 0; i < 3; ++i )
+		{
+			step[ i ] = _mm_set1_ps( edges[ i ].a * 4.f );
+			laneOffset[ i ] = _mm_mul_ps( _mm_set1_ps( edges[ i ].a ), lanes );
+		}
+
+		for ( int y = minY; y <= maxY; ++y )
+		{
+			float centerX = minX + 0.5f;
+			float centerY = y + 0.5f;
+			__m128 e[ 3 ];
+			for ( int i = 0; i < 3; ++i )
+				e[ i ] = _mm_add_ps( _mm_set1_ps( edges[ i ].a * centerX + edges[ i ].b * centerY + edges[ i ].c ), laneOffset[ i ] );
+
+			std::uint32_t *row = pixels + ( size_t )y * stride;
+			for ( int x = minX; x <= maxX; x += 4 )
+			{
+				__m128 inside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( e[ 0 ], zero ), _mm_cmpge_ps( e[ 1 ], zero ) ), _mm_cmpge_ps( e[ 2 ], zero ) );
+				if ( _mm_movemask_ps( inside ) )
+				{
+					__m128i mask = _mm_castps_si128( inside );
+					__m128i *target = reinterpret_cast< __m128i* >( row + x );
+					__m128i old = _mm_loadu_si128( target );
+					_mm_storeu_si128( target, _mm_or_si128( _mm_and_si128( mask, color ), _mm_andnot_si128( mask, old ) ) );
+				}
+				for ( int i = 0; i < 3; ++i )
+					e[ i ] = _mm_add_ps( e[ i ], step[ i ] );
+			}
+		}
+#else
+		// the same arithmetic one lane at a time, so both paths cover the same pixels
+		for ( int y = minY; y <= maxY; ++y )
+		{
+			float centerX = minX + 0.5f;
+			float centerY = y + 0.5f;
+			float e[ 3 ][ 4 ];
+			for ( int i = 0; i < 3; ++i )
+				for ( int lane = 0; lane < 4; ++lane )
+					e[ i ][ lane ] = ( edges[ i ].a * centerX + edges[ i ].b * centerY + edges[ i ].c ) + edges[ i ].a * lane;
+
+			std::uint32_t *row = pixels + ( size_t )y * stride;
+			for ( int x = minX; x <= maxX; x += 4 )
+			{
+				for ( int lane = 0; lane < 4; ++lane )
+				{
+					if ( e[ 0 ][ lane ] >= 0.f && e[ 1 ][ lane ] >= 0.f && e[ 2 ][ lane ] >= 0.f )
+						row[ x + lane ] = triangle.color;
+					for ( int i = 0; i < 3; ++i )
+						e[ i ][ lane ] += edges[ i ].a * 4.f;
+				}
+			}
+		}
+#endif
+	}
+}
+
+
+//-------------------------------------------------------
+//	renderer
+//-------------------------------------------------------
+
+namespace
+{
+	class SoftwareRenderer : public render::Renderer
+	{
+	public:
+		SoftwareRenderer( int width, int height );
+
+		void beginFrame( render::View const &view, render::Color clearColor ) override;
+		void endFrame() override;
+
+		void drawParticles( render::Vertex const *particles, int count, float pointSize ) override;
+		void drawMeshes( render::MeshType type, render::Instance const *instances, int count ) override;
+		void drawLines( render::Vertex const *vertices, int count, float width ) override;
+		void drawGlyphs( render::Glyph const *glyphs, int count, float scale ) override;
+		void drawScreenLines( render::Vertex const *vertices, int count ) override;
+
+		void readFrame( render::Image *image ) override;
+
+	private:
+		Point toPixels( float x, float y ) const;
+		void addTriangle( Point p0, Point p1, Point p2, std::uint32_t color );
+		void addQuad( Point center, Point halfAxisX, Point halfAxisY, std::uint32_t color );
+		void addLine( Point from, Point to, float width, std::uint32_t color );
+		void rasterizeTile( int tile );
+
+		int const width;
+		int const height;
+		int const tilesX;
+		int const tilesY;
+		int const stride;		// framebuffer rows are padded to whole tiles
+		std::vector< std::uint32_t > pixels;		// 0x00BBGGRR
+
+		float viewCenterX = 0.f;
+		float viewCenterY = 0.f;
+		float pixelsPerUnitX = 1.f;
+		float pixelsPerUnitY = 1.f;
+		std::uint32_t clearColor = 0;
+
+		// primitives of the frame in submission order, and per tile the ones touching it
+		std::vector< Triangle > triangles;
+		std::vector< std::vector< std::uint32_t > > tileTriangles;
+	};
+
+
+	//-------------------------------------------------------
+	SoftwareRenderer::SoftwareRenderer( int width, int height ) :
+		width( width ),
+		height( height ),
+		tilesX( ( width + TILE_SIZE - 1 ) / TILE_SIZE ),
+		tilesY( ( height + TILE_SIZE - 1 ) / TILE_SIZE ),
+		stride( tilesX * TILE_SIZE ),
+		pixels( ( size_t )tilesX * TILE_SIZE * tilesY * TILE_SIZE ),
+		tileTriangles( tilesX * tilesY )
+	{
+		assert( width > 0 && height > 0 );
+	}
+
+
+	//-------------------------------------------------------
+	Point SoftwareRenderer::toPixels( float x, float y ) const
+	{
+		// y points up in the world and down in the framebuffer
+		return Point{ 0.5f * width + ( x - viewCenterX ) * pixelsPerUnitX, 0.5f * height - ( y - viewCenterY ) * pixelsPerUnitY };
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::addTriangle( Point p0, Point p1, Point p2, std::uint32_t color )
+	{
+		// counter-clockwise on screen, so inside is where all edge functions are non-negative
+		Edge first = edgeBetween( p0, p1 );
+		float area = first.a * p2.x + first.b * p2.y + first.c;
+		if ( area == 0.f )
+			return;
+		if ( area < 0.f )
+			std::swap( p1, p2 );
+
+		Triangle triangle;
+		triangle.edges[ 0 ] = edgeBetween( p0, p1 );
+		triangle.edges[ 1 ] = edgeBetween( p1, p2 );
+		triangle.edges[ 2 ] = edgeBetween( p2, p0 );
+		triangle.minX = std::max( ( int )std::floor( std::min( { p0.x, p1.x, p2.x } ) ), 0 );
+		triangle.minY = std::max( ( int )std::floor( std::min( { p0.y, p1.y, p2.y } ) ), 0 );
+		triangle.maxX = std::min( ( int )std::ceil( std::max( { p0.x, p1.x, p2.x } ) ), width - 1 );
+		triangle.maxY = std::min( ( int )std::ceil( std::max( { p0.y, p1.y, p2.y } ) ), height - 1 );
+		triangle.color = color;
+		if ( triangle.minX > triangle.maxX || triangle.minY > triangle.maxY )
+			return;
+
+		std::uint32_t index = ( std::uint32_t )triangles.size();
+		triangles.push_back( triangle );
+		for ( int tileY = triangle.minY / TILE_SIZE; tileY <= triangle.maxY / TILE_SIZE; ++tileY )
+			for ( int tileX = triangle.minX / TILE_SIZE; tileX <= triangle.maxX / TILE_SIZE; ++tileX )
+				tileTriangles[ tileY * tilesX + tileX ].push_back( index );
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::addQuad( Point center, Point halfAxisX, Point halfAxisY, std::uint32_t color )
+	{
+		Point p0 = { center.x - halfAxisX.x - halfAxisY.x, center.y - halfAxisX.y - halfAxisY.y };
+		Point p1 = { center.x + halfAxisX.x - halfAxisY.x, center.y + halfAxisX.y - halfAxisY.y };
+		Point p2 = { center.x + halfAxisX.x + halfAxisY.x, center.y + halfAxisX.y + halfAxisY.y };
+		Point p3 = { center.x - halfAxisX.x + halfAxisY.x, center.y - halfAxisX.y + halfAxisY.y };
+		addTriangle( p0, p1, p2, color );
+		addTriangle( p0, p2, p3, color );
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::addLine( Point from, Point to, float width, std::uint32_t color )
+	{
+		// a quad width pixels across, like OpenGL's wide lines without the end caps
+		float dx = to.x - from.x;
+		float dy = to.y - from.y;
+		float length = std::sqrt( dx * dx + dy * dy );
+		if ( length == 0.f )
+			return;
+
+		Point along = { 0.5f * dx, 0.5f * dy };
+		Point across = { -dy / length * 0.5f * width, dx / length * 0.5f * width };
+		addQuad( Point{ from.x + along.x, from.y + along.y }, along, across, color );
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::beginFrame( render::View const &view, render::Color clear )
+	{
+		viewCenterX = view.centerX;
+		viewCenterY = view.centerY;
+		pixelsPerUnitX = width / view.width;
+		pixelsPerUnitY = height / view.height;
+		clearColor = packColor( clear.r, clear.g, clear.b );
+		triangles.clear();
+		for ( std::vector< std::uint32_t > &tile : tileTriangles )
+			tile.clear();
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::drawParticles( render::Vertex const *particles, int count, float pointSize )
+	{
+		Point halfX = { 0.5f * pointSize, 0.f };
+		Point halfY = { 0.f, 0.5f * pointSize };
+		for ( int i = 0; i < count; ++i )
+		{
+			render::Vertex const &particle = particles[ i ];
+			addQuad( toPixels( particle.x, particle.y ), halfX, halfY, packColor( particle.r, particle.g, particle.b ) );
+		}
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::drawMeshes( render::MeshType type, render::Instance const *instances, int count )
+	{
+		render::MeshGeometry const &geometry = render::meshGeometry( type );
+		std::vector< Point > outline( geometry.outline.size() );
+		for ( int i = 0; i < count; ++i )
+		{
+			render::Instance const &instance = instances[ i ];
+			float c = std::cos( instance.angle );
+			float s = std::sin( instance.angle );
+			auto place = [ & ]( render::Vertex const &vertex )
+			{
+				return toPixels( instance.x + c * vertex.x - s * vertex.y, instance.y + s * vertex.x + c * vertex.y );
+			};
+
+			std::vector< render::Vertex > const &vertices = geometry.triangles;
+			for ( size_t v = 0; v + 2 < vertices.size(); v += 3 )
+				addTriangle( place( vertices[ v ] ), place( vertices[ v + 1 ] ), place( vertices[ v + 2 ] ),
+							 packColor( vertices[ v ].r, vertices[ v ].g, vertices[ v ].b ) );
+
+			for ( size_t v = 0; v < outline.size(); ++v )
+				outline[ v ] = place( geometry.outline[ v ] );
+			for ( size_t v = 0; v < outline.size(); ++v )
+			{
+				render::Vertex const &vertex = geometry.outline[ v ];
+				addLine( outline[ v ], outline[ ( v + 1 ) % outline.size() ], geometry.outlineWidth, packColor( vertex.r, vertex.g, vertex.b ) );
+			}
+		}
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::drawLines( render::Vertex const *vertices, int count, float width )
+	{
+		for ( int i = 0; i + 1 < count; i += 2 )
+		{
+			render::Vertex const &from = vertices[ i ];
+			render::Vertex const &to = vertices[ i + 1 ];
+			addLine( toPixels( from.x, from.y ), toPixels( to.x, to.y ), width, packColor( from.r, from.g, from.b ) );
+		}
+	}
+
+
+	//-------------------------------------------------------
+	// each run of covered atlas pixels in a glyph row becomes one quad
+	void SoftwareRenderer::drawGlyphs( render::Glyph const *glyphs, int count, float scale )
+	{
+		render::GlyphAtlas const &atlas = render::glyphAtlas();
+		Point halfY = { 0.f, 0.5f * scale };
+		for ( int i = 0; i < count; ++i )
+		{
+			render::Glyph const &glyph = glyphs[ i ];
+			int atlasX, atlasY;
+			if ( !render::glyphCell( glyph.character, &atlasX, &atlasY ) )
+				continue;
+
+			std::uint32_t color = packColor( glyph.color.r, glyph.color.g, glyph.color.b );
+			for ( int row = 0; row < render::GLYPH_HEIGHT; ++row )
+			{
+				unsigned char const *coverage = &atlas.coverage[ ( size_t )( atlasY + row ) * atlas.width + atlasX ];
+				for ( int begin = 0, end; begin < render::GLYPH_WIDTH; begin = end )
+				{
+					for ( end = begin + 1; end < render::GLYPH_WIDTH && ( coverage[ end ] != 0 ) == ( coverage[ begin ] != 0 ); ++end )
+						;
+					if ( !coverage[ begin ] )
+						continue;
+					Point halfX = { 0.5f * ( end - begin ) * scale, 0.f };
+					Point center = { glyph.x + ( begin + end ) * 0.5f * scale, glyph.y + ( row + 0.5f ) * scale };
+					addQuad( center, halfX, halfY, color );
+				}
+			}
+		}
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::drawScreenLines( render::Vertex const *vertices, int count )
+	{
+		for ( int i = 0; i + 1 < count; i += 2 )
+		{
+			render::Vertex const &from = vertices[ i ];
+			render::Vertex const &to = vertices[ i + 1 ];
+			addLine( Point{ from.x, from.y }, Point{ to.x, to.y }, 1.f, packColor( from.r, from.g, from.b ) );
+		}
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::rasterizeTile( int tile )
+	{
+		int tileX = tile % tilesX * TILE_SIZE;
+		int tileY = tile / tilesX * TILE_SIZE;
+		for ( int y = tileY; y < tileY + TILE_SIZE; ++y )
+			std::fill_n( pixels.begin() + ( size_t )y * stride + tileX, TILE_SIZE, clearColor );
+
+		// in submission order, later primitives cover earlier ones like on the GPU
+		for ( std::uint32_t index : tileTriangles[ tile ] )
+			rasterize( triangles[ index ], tileX, tileY, pixels.data(), stride );
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::endFrame()
+	{
+		PROFILE_SCOPE( profiler::PHASE_RASTERIZE );
+
+		// tiles own disjoint pixels, so they need no synchronization
+		jobs::parallelFor( tilesX * tilesY, 1, [ this ]( int begin, int end )
+		{
+			for ( int tile = begin; tile < end; ++tile )
+				rasterizeTile( tile );
+		} );
+	}
+
+
+	//-------------------------------------------------------
+	void SoftwareRenderer::readFrame( render::Image *image )
+	{
+		image->width = width;
+		image->height = height;
+		image->pixels.resize( ( size_t )width * height * 3 );
+
+		unsigned char *target = image->pixels.data();
+		for ( int y = 0; y < height; ++y )
+		{
+			std::uint32_t const *row = pixels.data() + ( size_t )y * stride;
+			for ( int x = 0; x < width; ++x )
+			{
+				*target++ = ( unsigned char )row[ x ];
+				*target++ = ( unsigned char )( row[ x ] >> 8 );
+				*target++ = ( unsigned char )( row[ x ] >> 16 );
+			}
+		}
+	}
+}
+
+
+namespace render
+{
+	Renderer *createSoftwareRenderer( int width, int height )
+	{
+		return new SoftwareRenderer( width, height );
+	}
+}
@@ -0,0 +1,260 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "replay.hpp"
+#include "game.hpp"
+#include "scene.hpp"
+
+
+//-------------------------------------------------------
+//	dispatch
+//-------------------------------------------------------
+
+namespace replay
+{
+	void dispatch( Event const &event )
+	{
+		switch ( event.type )
+		{
+			case EVENT_KEY_PRESSED:
+				game::keyPressed( event.key );
+				break;
+
+			case EVENT_KEY_RELEASED:
+				game::keyReleased( event.key );
+				break;
+
+			case EVENT_MOUSE_CLICKED:
+				game::mouseClicked( event.x, event.y, event.key != 0 );
+				break;
+
+			case EVENT_RESTART:
+				game::deinit();
+				game::init();
+				break;
+
+			case EVENT_CAMERA_KEY_PRESSED:
+				scene::cameraKeyPressed( event.key );
+				break;
+
+			case EVENT_CAMERA_KEY_RELEASED:
+				scene::cameraKeyReleased( event.key );
+				break;
+
+			default:
+				assert( false );
+				break;
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	binary log format
+//-------------------------------------------------------
+
+//	header: "WOTSREC2", float tick time, int64 tick count, uint32 event count
+//	event:  LEB128 tick delta from the previous event, one byte with the type in the low
+//			three bits and the key in the rest, two floats for mouse clicks
+//	"WOTSREC1" logs predate the camera and keep the type in two bits
+
+namespace
+{
+	char const LOG_MAGIC[ 8 ] = { 'W', 'O', 'T', 'S', 'R', 'E', 'C', '2' };
+	char const LOG_MAGIC_VERSION_1[ 8 ] = { 'W', 'O', 'T', 'S', 'R', 'E', 'C', '1' };
+	constexpr int TYPE_BITS = 3;
+	constexpr int TYPE_BITS_VERSION_1 = 2;
+	static_assert( replay::EVENT_TYPE_COUNT <= 1 << TYPE_BITS, "event type must fit into its bits" );
+
+	std::vector< replay::Event > recordedEvents;
+	bool recording = false;
+
+
+	void writeVarint( std::vector< unsigned char > &buffer, std::uint64_t value )
+	{
+		do
+		{
+			unsigned char byte = value & 0x7f;
+			value >>= 7;
+			buffer.push_back( value ? byte | 0x80 : byte );
+		}
+		while ( value );
+	}
+
+
+	template< class Value >
+	void writeRaw( std::vector< unsigned char > &buffer, Value const &value )
+	{
+		unsigned char const *bytes = reinterpret_cast< unsigned char const* >( &value );
+		buffer.insert( buffer.end(), bytes, bytes + sizeof( value ) );
+	}
+
+
+	class Reader
+	{
+	public:
+		Reader( std::vector< unsigned char > const &buffer ) : data( buffer ), offset( 0 ) {}
+
+		void skip( size_t size )
+		{
+			offset = std::min( offset + size, data.size() );
+		}
+
+		bool readVarint( std::uint64_t *value )
+		{
+			*value = 0;
+			for ( int shift = 0; shift < 64; shift += 7 )
+			{
+				if ( offset >= data.size() )
+					return false;
+				unsigned char byte = data[ offset++ ];
+				*value |= ( std::uint64_t )( byte & 0x7f ) << shift;
+				if ( !( byte & 0x80 ) )
+					return true;
+			}
+			return false;
+		}
+
+		template< class Value >
+		bool readRaw( Value *value )
+		{
+			if ( data.size() - offset < sizeof( Value ) )
+				return false;
+			std::memcpy( value, &data[ offset ], sizeof( Value ) );
+			offset += sizeof( Value );
+			return true;
+		}
+
+	private:
+		std::vector< unsigned char > const &data;
+		size_t offset;
+	};
+}
+
+
+//-------------------------------------------------------
+//	recording
+//-------------------------------------------------------
+
+namespace replay
+{
+	void beginRecording()
+	{
+		recordedEvents.clear();
+		recording = true;
+	}
+
+
+	bool isRecording()
+	{
+		return recording;
+	}
+
+
+	void record( Event const &event )
+	{
+		assert( recording );
+		assert( recordedEvents.empty() || recordedEvents.back().tick <= event.tick );
+		recordedEvents.push_back( event );
+	}
+
+
+	bool saveRecording( char const *path, long long tickCount, float tickTime )
+	{
+		assert( recording );
+		recording = false;
+
+		std::vector< unsigned char > buffer;
+		buffer.insert( buffer.end(), LOG_MAGIC, LOG_MAGIC + sizeof( LOG_MAGIC ) );
+		writeRaw( buffer, tickTime );
+		writeRaw( buffer, ( std::int64_t )tickCount );
+		writeRaw( buffer, ( std::uint32_t )recordedEvents.size() );
+
+		long long previousTick = 0;
+		for ( Event const &event : recordedEvents )
+		{
+			assert( event.key >= 0 && event.key < 1 << ( 8 - TYPE_BITS ) );
+			writeVarint( buffer, ( std::uint64_t )( event.tick - previousTick ) );
+			buffer.push_back( ( unsigned char )( event.type | event.key << TYPE_BITS ) );
+			if ( event.type == EVENT_MOUSE_CLICKED )
+			{
+				writeRaw( buffer, event.x );
+				writeRaw( buffer, event.y );
+			}
+			previousTick = event.tick;
+		}
+
+		FILE *file = std::fopen( path, "wb" );
+		if ( !file )
+			return false;
+		bool written = std::fwrite( buffer.data(), 1, buffer.size(), file ) == buffer.size();
+		return std::fclose( file ) == 0 && written;
+	}
+}
+
+
+//-------------------------------------------------------
+//	loading
+//-------------------------------------------------------
+
+namespace replay
+{
+	bool load( char const *path, Log *log )
+	{
+		FILE *file = std::fopen( path, "rb" );
+		if ( !file )
+			return false;
+
+		std::vector< unsigned char > buffer;
+		unsigned char chunk[ 4096 ];
+		size_t read;
+		while ( ( read = std::fread( chunk, 1, sizeof( chunk ), file ) ) > 0 )
+			buffer.insert( buffer.end(), chunk, chunk + read );
+		std::fclose( file );
+
+		if ( buffer.size() < sizeof( LOG_MAGIC ) )
+			return false;
+		int typeBits;
+		if ( std::memcmp( buffer.data(), LOG_MAGIC, sizeof( LOG_MAGIC ) ) == 0 )
+			typeBits = TYPE_BITS;
+		else if ( std::memcmp( buffer.data(), LOG_MAGIC_VERSION_1, sizeof( LOG_MAGIC_VERSION_1 ) ) == 0 )
+			typeBits = TYPE_BITS_VERSION_1;
+		else
+			return false;
+
+		Reader reader( buffer );
+		reader.skip( sizeof( LOG_MAGIC ) );
+
+		std::int64_t tickCount;
+		std::uint32_t eventCount;
+		if ( !reader.readRaw( &log->tickTime ) || !reader.readRaw( &tickCount ) || !reader.readRaw( &eventCount ) )
+			return false;
+		log->tickCount = tickCount;
+
+		log->events.clear();
+		log->events.reserve( eventCount );
+		long long tick = 0;
+		for ( std::uint32_t i = 0; i < eventCount; ++i )
+		{
+			std::uint64_t tickDelta;
+			unsigned char typeAndKey;
+			if ( !reader.readVarint( &tickDelta ) || !reader.readRaw( &typeAndKey ) )
+				return false;
+
+			Event event = {};
+			tick += ( long long )tickDelta;
+			event.tick = tick;
+			event.type = ( EventType )( typeAndKey & ( ( 1 << typeBits ) - 1 ) );
+			event.key = typeAndKey >> typeBits;
+			if ( event.type >= EVENT_TYPE_COUNT )
+				return false;
+			if ( event.type == EVENT_MOUSE_CLICKED && ( !reader.readRaw( &event.x ) || !reader.readRaw( &event.y ) ) )
+				return false;
+			log->events.push_back( event );
+		}
+		return true;
+	}
+}
@@ -0,0 +1,42 @@
+#include <vector>
+
+
+namespace replay
+{
+	enum EventType
+	{
+		EVENT_KEY_PRESSED,
+		EVENT_KEY_RELEASED,
+		EVENT_MOUSE_CLICKED,
+		EVENT_RESTART,
+		EVENT_CAMERA_KEY_PRESSED,
+		EVENT_CAMERA_KEY_RELEASED,
+		EVENT_TYPE_COUNT
+	};
+
+	struct Event
+	{
+		long long tick;		// simulation ticks completed before the event was applied
+		EventType type;
+		int key;			// game::KEY_* or scene::CAMERA_* for keys, non-zero for the left button for clicks
+		float x;
+		float y;
+	};
+
+	// feeds the event through the same game and camera entry points window input uses
+	void dispatch( Event const &event );
+
+	void beginRecording();
+	bool isRecording();
+	void record( Event const &event );
+	bool saveRecording( char const *path, long long tickCount, float tickTime );
+
+	struct Log
+	{
+		long long tickCount;
+		float tickTime;
+		std::vector< Event > events;		// ordered by tick
+	};
+
+	bool load( char const *path, Log *log );
+}
@@ -1,19 +1,32 @@
 
-#include <windows.h>
-#include <GL/gl.h>
-
 #include <cassert>
+#include <cmath>
 #include <vector>
 #include <algorithm>
 #include <random>
+#include <atomic>
+#include <mutex>
 
 #include "scene.hpp"
+#include "profiler.hpp"
+#include "jobs.hpp"
+#include "render.hpp"
+#include "grid.hpp"
+#include "hud.hpp"
+#include "slot_map.hpp"
+#include "memory.hpp"
+#include "platform.hpp"
 
 
 namespace scene
 {
+	// seen at zoom 1
 	constexpr float VIEW_WIDTH = 18.f;
 	constexpr float VIEW_HEIGHT = 13.5f;
+
+	// centered on the origin, the camera stays inside
+	constexpr float WORLD_WIDTH = 4096.f;
+	constexpr float WORLD_HEIGHT = 4096.f;
 }
 
 
@@ -38,37 +51,32 @@ namespace
 	};
 
 
+	constexpr int PARTICLE_UPDATE_GRAIN = 4096;
+	constexpr float PARTICLE_SIZE = 2.f;
+
 	std::vector< Particle > particles;
 
+	// set while a job updates meshes, spawned particles are merged in chunk order afterwards
+	thread_local std::vector< Particle > *spawnedParticles = nullptr;
+
 
 	void addParticle( float x, float y, float life, Color color )
 	{
 		Particle particle = { x, y, life, color };
-		particles.push_back( particle );
+		( spawnedParticles ? *spawnedParticles : particles ).push_back( particle );
 	}
 
 
 	void updateParticles( float dt )
 	{
-		for ( Particle &particle : particles )
-			particle.life -= dt;
+		jobs::parallelFor( ( int )particles.size(), PARTICLE_UPDATE_GRAIN, [ dt ]( int begin, int end )
+		{
+			for ( int i = begin; i < end; ++i )
+				particles[ i ].life -= dt;
+		} );
 		auto newEnd = std::remove_if( particles.begin(), particles.end(), []( Particle &particle ){ return particle.life <= 0.f; } );
 		particles.erase( newEnd, particles.end() );
 	}
-
-
-	void drawParticles()
-	{
-		glLoadIdentity();
-		glPointSize( 2.f );
-		glBegin( GL_POINTS );
-		for ( Particle const &particle : particles )
-		{
-			glColor3f( particle.color.r, particle.color.g, particle.color.b );
-			glVertex2f( particle.x, particle.y );
-		}
-		glEnd();
-	}
 }
 
 
@@ -78,138 +86,492 @@ namespace
 
 namespace scene
 {
-	class Mesh
+	struct Transform
+	{
+		float positionX;
+		float positionY;
+		float angle;
+	};
+
+
+	// the meshes of one type with one array per field, all indexed alike, so updates run through
+	// them in tight loops instead of chasing a pointer and a virtual call per mesh; removing a mesh
+	// moves the last one into its place
+	class MeshArrays
 	{
 	public:
-		float positionX = 0.f;
-		float positionY = 0.f;
-		float angle = 0.f;
+		explicit MeshArrays( render::MeshType meshType ) : type( meshType ) {}
+		virtual ~MeshArrays() = default;
+
+		render::MeshType const type;
+
+		// placement relative to the parent, in the world for meshes without one
+		std::vector< float > positionX;
+		std::vector< float > positionY;
+		std::vector< float > angle;
+
+		// placement in the world, recomputed for the subtrees of dirty meshes at the start of update();
+		// placing a mesh where it already is does not make it dirty
+		std::vector< Transform > world;
+		std::vector< unsigned char > dirty;
 
-		virtual ~Mesh();
-		virtual void draw();
-		virtual void update( float dt );
+		// no parent for the default handle; children are linked through their next sibling
+		std::vector< containers::SlotHandle > parent;
+		std::vector< containers::SlotHandle > firstChild;
+		std::vector< containers::SlotHandle > nextSibling;
 
-		static std::vector< Mesh* > meshes;
+		// placement at the end of the two latest simulation ticks, drawing blends between them
+		std::vector< Transform > previousTick;
+		std::vector< Transform > lastTick;
+		std::vector< unsigned char > ticked;
+
+		// set by destroyMesh(), the mesh stays until the next update()
+		std::vector< unsigned char > destroyed;
+
+		// the slot of each mesh, pointed at the new index when the mesh moves
+		std::vector< containers::SlotHandle > handles;
+
+		int size() const { return ( int )handles.size(); }
+
+		// types with state of their own keep it in arrays next to these
+		virtual int add( containers::SlotHandle handle );
+		virtual void remove( int index );
+		virtual void reserve( int count );
+
+		// from parallel jobs over disjoint index ranges
+		virtual void update( int begin, int end, float dt );
+		void endTick( int begin, int end );
+	};
+
+
+	struct MeshLocation
+	{
+		render::MeshType type;
+		int index;
 	};
 
 
 	//-------------------------------------------------------
-	std::vector< Mesh* > Mesh::meshes;
+	containers::SlotMap< MeshLocation > meshLocations;
+
+	// aircraft land and destroy their meshes from parallel game updates, so destroyed meshes are
+	// only erased at the start of the next update, in slot order: erasing moves meshes around
+	// and reuses slots, and in destruction order the outcome would depend on timing
+	std::mutex destroyedMeshesMutex;
+	std::vector< containers::SlotHandle > destroyedMeshes;
+
+	// guards the child lists, meshes are attached and detached from parallel game updates
+	std::mutex hierarchyMutex;
+
+	// by type, defined with the types
+	MeshArrays &meshArrays( render::MeshType type );
 
 
 	//-------------------------------------------------------
-	Mesh::~Mesh()
+	containers::SlotHandle toSlotHandle( MeshHandle mesh )
 	{
+		containers::SlotHandle handle;
+		handle.index = mesh.index;
+		handle.generation = mesh.generation;
+		return handle;
 	}
 
 
 	//-------------------------------------------------------
-	void Mesh::draw()
+	// null for stale handles and meshes already destroyed
+	MeshLocation const *findMesh( MeshHandle handle )
 	{
-		glLoadIdentity();
-		glTranslatef( positionX, positionY, 0.f );
-		glRotatef( angle * 180.f / 3.14159265f, 0.f, 0.f, 1.f );
+		MeshLocation const *location = meshLocations.find( toSlotHandle( handle ) );
+		return location && !meshArrays( location->type ).destroyed[ location->index ] ? location : nullptr;
 	}
 
 
 	//-------------------------------------------------------
-	void Mesh::update( float dt )
+	int MeshArrays::add( containers::SlotHandle handle )
 	{
+		profiler::addCount( profiler::COUNTER_MESH_STORAGE_GROWTH, handles.size() == handles.capacity() ? 1 : 0 );
+
+		positionX.push_back( 0.f );
+		positionY.push_back( 0.f );
+		angle.push_back( 0.f );
+		world.push_back( Transform{} );
+		dirty.push_back( false );
+		parent.push_back( containers::SlotHandle() );
+		firstChild.push_back( containers::SlotHandle() );
+		nextSibling.push_back( containers::SlotHandle() );
+		previousTick.push_back( Transform{} );
+		lastTick.push_back( Transform{} );
+		ticked.push_back( false );
+		destroyed.push_back( false );
+		handles.push_back( handle );
+		return size() - 1;
 	}
 
 
 	//-------------------------------------------------------
-	template< class MeshClass >
-	Mesh *createMesh()
+	template< class Value >
+	void removeSwapped( std::vector< Value > &values, int index )
 	{
-		Mesh *mesh = new MeshClass;
-		Mesh::meshes.push_back( mesh );
-		return mesh;
+		values[ index ] = values.back();
+		values.pop_back();
 	}
 
 
 	//-------------------------------------------------------
-	void destroyMesh( Mesh *mesh )
+	void MeshArrays::remove( int index )
 	{
-		auto it = std::find( Mesh::meshes.begin(), Mesh::meshes.end(), mesh );
-		assert( it != Mesh::meshes.end() );
-		Mesh::meshes.erase( it );
-		delete mesh;
+		removeSwapped( positionX, index );
+		removeSwapped( positionY, index );
+		removeSwapped( angle, index );
+		removeSwapped( world, index );
+		removeSwapped( dirty, index );
+		removeSwapped( parent, index );
+		removeSwapped( firstChild, index );
+		removeSwapped( nextSibling, index );
+		removeSwapped( previousTick, index );
+		removeSwapped( lastTick, index );
+		removeSwapped( ticked, index );
+		removeSwapped( destroyed, index );
+		removeSwapped( handles, index );
 	}
 
 
 	//-------------------------------------------------------
-	void placeMesh( Mesh *mesh, float x, float y, float angle )
+	void MeshArrays::reserve( int count )
 	{
-		mesh->positionX = x;
-		mesh->positionY = y;
-		mesh->angle = angle;
+		positionX.reserve( count );
+		positionY.reserve( count );
+		angle.reserve( count );
+		world.reserve( count );
+		dirty.reserve( count );
+		parent.reserve( count );
+		firstChild.reserve( count );
+		nextSibling.reserve( count );
+		previousTick.reserve( count );
+		lastTick.reserve( count );
+		ticked.reserve( count );
+		destroyed.reserve( count );
+		handles.reserve( count );
 	}
-}
 
 
-//-------------------------------------------------------
-//	user interface: ShipMesh support
-//-------------------------------------------------------
+	//-------------------------------------------------------
+	void MeshArrays::update( int begin, int end, float dt )
+	{
+	}
 
-namespace
-{
-	class ShipMesh : public scene::Mesh
+
+	//-------------------------------------------------------
+	void MeshArrays::endTick( int begin, int end )
 	{
-	public:
-		void draw() override;
-	};
+		for ( int i = begin; i < end; ++i )
+		{
+			previousTick[ i ] = ticked[ i ] ? lastTick[ i ] : world[ i ];
+			lastTick[ i ] = world[ i ];
+			ticked[ i ] = true;
+		}
+	}
+
+
+	//-------------------------------------------------------
+	Transform interpolate( Transform const &from, Transform const &to, float interpolation )
+	{
+		constexpr float PI = 3.14159265f;
+
+		Transform result;
+		result.positionX = from.positionX + ( to.positionX - from.positionX ) * interpolation;
+		result.positionY = from.positionY + ( to.positionY - from.positionY ) * interpolation;
+		result.angle = from.angle + std::remainder( to.angle - from.angle, 2.f * PI ) * interpolation;
+		return result;
+	}
+
+
+	//-------------------------------------------------------
+	// local is relative to parent
+	Transform combine( Transform const &parent, Transform const &local )
+	{
+		float c = std::cos( parent.angle );
+		float s = std::sin( parent.angle );
+
+		Transform result;
+		result.positionX = parent.positionX + c * local.positionX - s * local.positionY;
+		result.positionY = parent.positionY + s * local.positionX + c * local.positionY;
+		result.angle = parent.angle + local.angle;
+		return result;
+	}
+
+
+	//-------------------------------------------------------
+	// world relative to parent, undoes combine()
+	Transform relativeTo( Transform const &parent, Transform const &world )
+	{
+		float c = std::cos( parent.angle );
+		float s = std::sin( parent.angle );
+		float dx = world.positionX - parent.positionX;
+		float dy = world.positionY - parent.positionY;
+
+		Transform result;
+		result.positionX = c * dx + s * dy;
+		result.positionY = -s * dx + c * dy;
+		result.angle = world.angle - parent.angle;
+		return result;
+	}
 
 
 	//-------------------------------------------------------
-	void ShipMesh::draw()
+	// cached world placement of the mesh behind a handle that is known to be valid
+	Transform const &worldTransform( containers::SlotHandle handle )
 	{
-		Mesh::draw();
+		MeshLocation const &location = *meshLocations.find( handle );
+		return meshArrays( location.type ).world[ location.index ];
+	}
 
-		glRotatef( -90.f, 0.f, 0.f, 1.f );
-		glScalef( 0.8f, 0.8f, 0.8f );
 
-		glBegin( GL_TRIANGLES );
-		glColor3f( 0.1f, 0.3f, 0.6f );
+	//-------------------------------------------------------
+	// recomputes the world placement of the mesh and everything attached to it
+	int updateWorldTransforms( MeshLocation location )
+	{
+		MeshArrays &meshes = meshArrays( location.type );
+		int i = location.index;
+		Transform local = { meshes.positionX[ i ], meshes.positionY[ i ], meshes.angle[ i ] };
+		meshes.world[ i ] = meshes.parent[ i ] ? combine( worldTransform( meshes.parent[ i ] ), local ) : local;
+		meshes.dirty[ i ] = false;
+
+		int updated = 1;
+		for ( containers::SlotHandle child = meshes.firstChild[ i ]; child; )
+		{
+			MeshLocation childLocation = *meshLocations.find( child );
+			updated += updateWorldTransforms( childLocation );
+			child = meshArrays( childLocation.type ).nextSibling[ childLocation.index ];
+		}
+		return updated;
+	}
 
-		glVertex2f( -0.1f, -0.4f );
-		glVertex2f( 0.1f, -0.4f );
-		glVertex2f( 0.1f, 0.4f );
 
-		glVertex2f( -0.1f, 0.4f );
-		glVertex2f( 0.1f, 0.4f );
-		glVertex2f( -0.1f, -0.4f );
+	//-------------------------------------------------------
+	// from the top of every dirty subtree, meshes below only move along with their parents
+	void updateWorldTransforms( MeshArrays *const *types, int typeCount )
+	{
+		int updated = 0;
+		int meshCount = 0;
+		for ( int type = 0; type < typeCount; ++type )
+		{
+			MeshArrays &meshes = *types[ type ];
+			meshCount += meshes.size();
+			for ( int i = 0; i < meshes.size(); ++i )
+			{
+				if ( !meshes.dirty[ i ] )
+					continue;
+
+				MeshLocation top = { meshes.type, i };
+				for ( ;; )
+				{
+					containers::SlotHandle parent = meshArrays( top.type ).parent[ top.index ];
+					if ( !parent )
+						break;
+					MeshLocation parentLocation = *meshLocations.find( parent );
+					if ( !meshArrays( parentLocation.type ).dirty[ parentLocation.index ] )
+						break;
+					top = parentLocation;
+				}
+				updated += updateWorldTransforms( top );
+			}
+		}
+		profiler::addCount( profiler::COUNTER_MESHES_DIRTY, updated );
+		profiler::addCount( profiler::COUNTER_MESHES_CLEAN, meshCount - updated );
+	}
 
-		glVertex2f( -0.1f, -0.4f );
-		glVertex2f( -0.1f, 0.4f );
-		glVertex2f( -0.15f, -0.1f );
 
-		glVertex2f( 0.1f, -0.4f );
-		glVertex2f( 0.1f, 0.4f );
-		glVertex2f( 0.15f, -0.1f );
+	//-------------------------------------------------------
+	// takes the mesh out of its parent's child list, with the hierarchy locked or serially
+	void unlinkFromParent( MeshArrays &meshes, int index )
+	{
+		containers::SlotHandle parent = meshes.parent[ index ];
+		MeshLocation const &parentLocation = *meshLocations.find( parent );
+		containers::SlotHandle *link = &meshArrays( parentLocation.type ).firstChild[ parentLocation.index ];
+		while ( *link != meshes.handles[ index ] )
+		{
+			MeshLocation const &sibling = *meshLocations.find( *link );
+			link = &meshArrays( sibling.type ).nextSibling[ sibling.index ];
+		}
+		*link = meshes.nextSibling[ index ];
+		meshes.nextSibling[ index ] = containers::SlotHandle();
+		meshes.parent[ index ] = containers::SlotHandle();
+	}
 
-		glEnd();
 
-		glLineWidth( 2.f );
-		glBegin( GL_LINE_LOOP );
-		glColor3f( 0.4f, 0.8f, 1.f );
-		glVertex2f( -0.1f, -0.4f );
-		glVertex2f( 0.1f, -0.4f );
-		glVertex2f( 0.15f, -0.1f );
-		glVertex2f( 0.1f, 0.4f );
-		glVertex2f( -0.1f, 0.4f );
-		glVertex2f( -0.15f, -0.1f );
-		glEnd();
+	//-------------------------------------------------------
+	// keeps the mesh where it was last placed in the world
+	void detach( MeshArrays &meshes, int index )
+	{
+		unlinkFromParent( meshes, index );
+		Transform const &world = meshes.world[ index ];
+		meshes.positionX[ index ] = world.positionX;
+		meshes.positionY[ index ] = world.positionY;
+		meshes.angle[ index ] = world.angle;
+		meshes.dirty[ index ] = true;
+	}
+
+
+	//-------------------------------------------------------
+	// from the simulation thread outside of parallel updates
+	MeshHandle createMesh( MeshArrays &meshes )
+	{
+		containers::SlotHandle slot = meshLocations.insert( MeshLocation{ meshes.type, meshes.size() } );
+		meshes.add( slot );
+		profiler::addCount( profiler::COUNTER_MESHES_CREATED, 1 );
+
+		MeshHandle handle;
+		handle.index = slot.index;
+		handle.generation = slot.generation;
+		return handle;
+	}
+
+
+	//-------------------------------------------------------
+	void eraseDestroyedMeshes()
+	{
+		std::sort( destroyedMeshes.begin(), destroyedMeshes.end(), []( containers::SlotHandle a, containers::SlotHandle b ) { return a.index < b.index; } );
+		for ( containers::SlotHandle handle : destroyedMeshes )
+		{
+			MeshLocation location = *meshLocations.find( handle );
+			MeshArrays &meshes = meshArrays( location.type );
+			if ( meshes.parent[ location.index ] )
+				unlinkFromParent( meshes, location.index );
+			while ( containers::SlotHandle child = meshes.firstChild[ location.index ] )
+			{
+				MeshLocation const &childLocation = *meshLocations.find( child );
+				detach( meshArrays( childLocation.type ), childLocation.index );
+			}
+			meshes.remove( location.index );
+			if ( location.index < meshes.size() )
+				meshLocations.find( meshes.handles[ location.index ] )->index = location.index;
+			meshLocations.erase( handle );
+		}
+		destroyedMeshes.clear();
+	}
+
+
+	//-------------------------------------------------------
+	void destroyMesh( MeshHandle handle )
+	{
+		MeshLocation const *location = findMesh( handle );
+		assert( location && "destroying a stale mesh handle" );
+		if ( !location )
+			return;
+
+		meshArrays( location->type ).destroyed[ location->index ] = true;
+		std::lock_guard< std::mutex > lock( destroyedMeshesMutex );
+		destroyedMeshes.push_back( toSlotHandle( handle ) );
+	}
+
+
+	//-------------------------------------------------------
+	bool isMeshAlive( MeshHandle handle )
+	{
+		return findMesh( handle ) != nullptr;
+	}
+
+
+	//-------------------------------------------------------
+	void placeMesh( MeshHandle handle, float x, float y, float angle )
+	{
+		MeshLocation const *location = findMesh( handle );
+		assert( location && "placing a stale mesh handle" );
+		if ( !location )
+			return;
+
+		MeshArrays &meshes = meshArrays( location->type );
+		int i = location->index;
+		if ( meshes.positionX[ i ] == x && meshes.positionY[ i ] == y && meshes.angle[ i ] == angle )
+			return;
+
+		meshes.positionX[ i ] = x;
+		meshes.positionY[ i ] = y;
+		meshes.angle[ i ] = angle;
+		meshes.dirty[ i ] = true;
+
+		// meshes on their own are placed in the world right away, so attachMesh() sees where they are
+		if ( !meshes.parent[ i ] )
+			meshes.world[ i ] = Transform{ x, y, angle };
+
+		// not simulated yet, there is nothing to blend with
+		if ( !meshes.ticked[ i ] )
+		{
+			Transform local = { x, y, angle };
+			meshes.previousTick[ i ] = meshes.lastTick[ i ] = meshes.parent[ i ] ? combine( worldTransform( meshes.parent[ i ] ), local ) : local;
+		}
+	}
+
+
+	//-------------------------------------------------------
+	void attachMesh( MeshHandle child, MeshHandle parent )
+	{
+		MeshLocation const *childLocation = findMesh( child );
+		MeshLocation const *parentLocation = findMesh( parent );
+		assert( childLocation && parentLocation && "attaching a stale mesh handle" );
+		if ( !childLocation || !parentLocation )
+			return;
+
+		std::lock_guard< std::mutex > lock( hierarchyMutex );
+		MeshArrays &meshes = meshArrays( childLocation->type );
+		int i = childLocation->index;
+		if ( meshes.parent[ i ] )
+			detach( meshes, i );
+
+		containers::SlotHandle parentHandle = toSlotHandle( parent );
+		for ( containers::SlotHandle ancestor = parentHandle; ancestor; )
+		{
+			assert( ancestor != meshes.handles[ i ] && "attaching a mesh below itself" );
+			MeshLocation const &ancestorLocation = *meshLocations.find( ancestor );
+			ancestor = meshArrays( ancestorLocation.type ).parent[ ancestorLocation.index ];
+		}
+
+		// stays where it is in the world until placed relative to the parent
+		MeshArrays &parentMeshes = meshArrays( parentLocation->type );
+		Transform local = relativeTo( parentMeshes.world[ parentLocation->index ], meshes.world[ i ] );
+		meshes.positionX[ i ] = local.positionX;
+		meshes.positionY[ i ] = local.positionY;
+		meshes.angle[ i ] = local.angle;
+		meshes.dirty[ i ] = true;
+
+		meshes.parent[ i ] = parentHandle;
+		meshes.nextSibling[ i ] = parentMeshes.firstChild[ parentLocation->index ];
+		parentMeshes.firstChild[ parentLocation->index ] = meshes.handles[ i ];
+	}
+
+
+	//-------------------------------------------------------
+	void detachMesh( MeshHandle child )
+	{
+		MeshLocation const *location = findMesh( child );
+		assert( location && "detaching a stale mesh handle" );
+		if ( !location )
+			return;
+
+		std::lock_guard< std::mutex > lock( hierarchyMutex );
+		MeshArrays &meshes = meshArrays( location->type );
+		if ( meshes.parent[ location->index ] )
+			detach( meshes, location->index );
 	}
 }
 
 
+//-------------------------------------------------------
+//	user interface: ShipMesh support
+//-------------------------------------------------------
+
+namespace
+{
+	scene::MeshArrays shipMeshes( render::MESH_SHIP );
+}
+
 namespace scene
 {
 	//-------------------------------------------------------
-	Mesh *createShipMesh()
+	MeshHandle createShipMesh()
 	{
-		return createMesh< ShipMesh >();
+		return createMesh( shipMeshes );
 	}
 }
 
@@ -220,53 +582,59 @@ namespace scene
 
 namespace
 {
-	class AircraftMesh : public scene::Mesh
+	class AircraftMeshes : public scene::MeshArrays
 	{
 	public:
-		void draw() override;
-		void update( float dt ) override;
+		AircraftMeshes() : MeshArrays( render::MESH_AIRCRAFT ) {}
+
+		int add( containers::SlotHandle handle ) override;
+		void remove( int index ) override;
+		void reserve( int count ) override;
+		void update( int begin, int end, float dt ) override;
 
 	private:
-		float nextParticleTimeout = 0.f;
+		std::vector< float > nextParticleTimeout;
 	};
 
 
+	AircraftMeshes aircraftMeshes;
+
+
 	//-------------------------------------------------------
-	void AircraftMesh::draw()
+	int AircraftMeshes::add( containers::SlotHandle handle )
 	{
-		Mesh::draw();
+		nextParticleTimeout.push_back( 0.f );
+		return MeshArrays::add( handle );
+	}
+
 
-		glRotatef( -90.f, 0.f, 0.f, 1.f );
+	//-------------------------------------------------------
+	void AircraftMeshes::remove( int index )
+	{
+		scene::removeSwapped( nextParticleTimeout, index );
+		MeshArrays::remove( index );
+	}
 
-		glBegin( GL_TRIANGLES );
-		glColor3f( 0.5f, 0.6f, 0.1f );
-		glVertex2f( -0.06f, -0.1f );
-		glVertex2f( 0.06f, -0.1f );
-		glVertex2f( 0.f, 0.1f );
-		glVertex2f( -0.1f, -0.1f );
-		glVertex2f( 0.1f, -0.1f );
-		glVertex2f( 0.f, 0.0f );
-		glEnd();
 
-		glLineWidth( 2.f );
-		glBegin( GL_LINE_LOOP );
-		glColor3f( 0.8f, 1.f, 0.2f );
-		glVertex2f( -0.1f, -0.1f );
-		glVertex2f( 0.1f, -0.1f );
-		glVertex2f( 0.04f, -0.04f );
-		glVertex2f( 0.f, 0.1f );
-		glVertex2f( -0.04f, -0.04f );
-		glEnd();
+	//-------------------------------------------------------
+	void AircraftMeshes::reserve( int count )
+	{
+		nextParticleTimeout.reserve( count );
+		MeshArrays::reserve( count );
 	}
 
 
-	void AircraftMesh::update( float dt )
+	//-------------------------------------------------------
+	void AircraftMeshes::update( int begin, int end, float dt )
 	{
-		nextParticleTimeout -= dt;
-		if ( nextParticleTimeout <= 0.f )
+		for ( int i = begin; i < end; ++i )
 		{
-			nextParticleTimeout += 0.1f;
-			addParticle( positionX, positionY, 0.8f, Color{ 1.f, 1.f, 1.f } );
+			nextParticleTimeout[ i ] -= dt;
+			if ( nextParticleTimeout[ i ] <= 0.f )
+			{
+				nextParticleTimeout[ i ] += 0.1f;
+				addParticle( world[ i ].positionX, world[ i ].positionY, 0.8f, Color{ 1.f, 1.f, 1.f } );
+			}
 		}
 	}
 }
@@ -274,9 +642,40 @@ namespace
 namespace scene
 {
 	//-------------------------------------------------------
-	Mesh *createAircraftMesh()
+	MeshHandle createAircraftMesh()
 	{
-		return createMesh< AircraftMesh >();
+		return createMesh( aircraftMeshes );
+	}
+}
+
+
+//-------------------------------------------------------
+//	user interface: mesh storage by type
+//-------------------------------------------------------
+
+namespace scene
+{
+	// in drawing order, ships first so aircraft on deck stay on top
+	MeshArrays *const meshTypes[ render::MESH_TYPE_COUNT ] = { &shipMeshes, &aircraftMeshes };
+
+
+	//-------------------------------------------------------
+	MeshArrays &meshArrays( render::MeshType type )
+	{
+		assert( type >= 0 && type < render::MESH_TYPE_COUNT && meshTypes[ type ]->type == type );
+		return *meshTypes[ type ];
+	}
+
+
+	//-------------------------------------------------------
+	void reserveMeshes( int ships, int aircraft )
+	{
+		shipMeshes.reserve( shipMeshes.size() + ships );
+		aircraftMeshes.reserve( aircraftMeshes.size() + aircraft );
+
+		// erased meshes give their slots back, so only the peak count needs room
+		meshLocations.reserve( meshLocations.size() + ships + aircraft );
+		destroyedMeshes.reserve( meshLocations.size() + ships + aircraft );
 	}
 }
 
@@ -287,24 +686,27 @@ namespace scene
 
 namespace
 {
-	struct
+	struct GoalMarker
 	{
 		float x;
 		float y;
-	} goalMarker;
+	};
+
+
+	GoalMarker goalMarker;
 
 
-	void drawGoalMarker()
+	void drawGoalMarker( GoalMarker const &goalMarker, render::CommandBuffer &commands )
 	{
-		glLoadIdentity();
-		glLineWidth( 3.f );
-		glBegin( GL_LINES );
-		glColor3f( 1.0f, 0.3f, 0.2f );
-		glVertex2f( goalMarker.x - 0.1f, goalMarker.y - 0.1f );
-		glVertex2f( goalMarker.x + 0.1f, goalMarker.y + 0.1f );
-		glVertex2f( goalMarker.x - 0.1f, goalMarker.y + 0.1f );
-		glVertex2f( goalMarker.x + 0.1f, goalMarker.y - 0.1f );
-		glEnd();
+		float const r = 1.0f, g = 0.3f, b = 0.2f;
+		render::Vertex const lines[] =
+		{
+			{ goalMarker.x - 0.1f, goalMarker.y - 0.1f, r, g, b },
+			{ goalMarker.x + 0.1f, goalMarker.y + 0.1f, r, g, b },
+			{ goalMarker.x - 0.1f, goalMarker.y + 0.1f, r, g, b },
+			{ goalMarker.x + 0.1f, goalMarker.y - 0.1f, r, g, b },
+		};
+		commands.drawLines( render::LAYER_INTERFACE, lines, 4, 3.f );
 	}
 }
 
@@ -319,6 +721,77 @@ namespace scene
 }
 
 
+//-------------------------------------------------------
+//	camera
+//-------------------------------------------------------
+
+namespace
+{
+	struct Camera
+	{
+		float x;
+		float y;
+		float zoom;
+	};
+
+
+	constexpr float CAMERA_PAN_SPEED = 0.5f;		// view sizes per second
+	constexpr float CAMERA_ZOOM_SPEED = 2.f;		// zoom factor per second
+	constexpr float CAMERA_MIN_ZOOM = scene::VIEW_WIDTH / scene::WORLD_WIDTH;
+	constexpr float CAMERA_MAX_ZOOM = 8.f;
+
+	// simulated like the game, so clicks map to the same world positions in replays
+	Camera camera = { 0.f, 0.f, 1.f };
+	Camera cameraPreviousUpdate = camera;
+	bool cameraKeysDown[ scene::CAMERA_KEY_COUNT ];
+
+
+	render::View cameraView( Camera const &camera )
+	{
+		return render::View{ camera.x, camera.y, scene::VIEW_WIDTH / camera.zoom, scene::VIEW_HEIGHT / camera.zoom };
+	}
+
+
+	float clampToWorld( float center, float viewSize, float worldSize )
+	{
+		float limit = std::max( 0.5f * ( worldSize - viewSize ), 0.f );
+		return std::min( std::max( center, -limit ), limit );
+	}
+
+
+	void updateCamera( float dt )
+	{
+		cameraPreviousUpdate = camera;
+
+		float zoomIn = ( float )cameraKeysDown[ scene::CAMERA_ZOOM_IN ] - ( float )cameraKeysDown[ scene::CAMERA_ZOOM_OUT ];
+		camera.zoom = std::min( std::max( camera.zoom * std::pow( CAMERA_ZOOM_SPEED, zoomIn * dt ), CAMERA_MIN_ZOOM ), CAMERA_MAX_ZOOM );
+
+		render::View view = cameraView( camera );
+		float panX = ( float )cameraKeysDown[ scene::CAMERA_PAN_RIGHT ] - ( float )cameraKeysDown[ scene::CAMERA_PAN_LEFT ];
+		float panY = ( float )cameraKeysDown[ scene::CAMERA_PAN_UP ] - ( float )cameraKeysDown[ scene::CAMERA_PAN_DOWN ];
+		camera.x = clampToWorld( camera.x + panX * CAMERA_PAN_SPEED * view.width * dt, view.width, scene::WORLD_WIDTH );
+		camera.y = clampToWorld( camera.y + panY * CAMERA_PAN_SPEED * view.height * dt, view.height, scene::WORLD_HEIGHT );
+	}
+}
+
+
+namespace scene
+{
+	void cameraKeyPressed( int key )
+	{
+		assert( key >= 0 && key < CAMERA_KEY_COUNT );
+		cameraKeysDown[ key ] = true;
+	}
+
+
+	void cameraKeyReleased( int key )
+	{
+		assert( key >= 0 && key < CAMERA_KEY_COUNT );
+		cameraKeysDown[ key ] = false;
+	}
+}
+
+
 //-------------------------------------------------------
 //	user interface: utility functions
 //-------------------------------------------------------
@@ -327,8 +800,64 @@ namespace scene
 {
 	void screenToWorld( float *x, float *y )
 	{
-		*x = 0.5f * VIEW_WIDTH * ( 2.f * *x - 1.f );
-		*y = 0.5f * VIEW_HEIGHT * ( 2.f * *y - 1.f );
+		render::View view = cameraView( camera );
+		*x = view.centerX + 0.5f * view.width * ( 2.f * *x - 1.f );
+		*y = view.centerY + 0.5f * view.height * ( 2.f * *y - 1.f );
+	}
+}
+
+
+//-------------------------------------------------------
+//	snapshots shared between simulation and rendering
+//-------------------------------------------------------
+
+namespace
+{
+	struct MeshSnapshot
+	{
+		render::MeshType type;
+		bool moved;				// between the two ticks, still meshes are drawn as they are without blending
+		scene::Transform previousTick;
+		scene::Transform lastTick;
+	};
+
+
+	// a few screens at zoom 1, the camera overlaps a handful of cells when zoomed in
+	constexpr float GRID_CELL_SIZE = 32.f;
+
+
+	struct Snapshot
+	{
+		long long tick = 0;
+		Camera previousCamera = {};
+		Camera lastCamera = {};
+
+		// sorted by grid cell of their latest position
+		std::vector< MeshSnapshot > meshes;
+		std::vector< render::Vertex > particles;		// ready to upload as they are
+		grid::UniformGrid meshGrid = grid::UniformGrid( scene::WORLD_WIDTH, scene::WORLD_HEIGHT, GRID_CELL_SIZE );
+		grid::UniformGrid particleGrid = grid::UniformGrid( scene::WORLD_WIDTH, scene::WORLD_HEIGHT, GRID_CELL_SIZE );
+
+		GoalMarker goalMarker = {};
+	};
+
+
+	// triple buffer: the simulation fills the back snapshot and swaps it with the shared middle one,
+	// the renderer swaps its front snapshot with the middle one whenever that one is marked fresh
+	constexpr unsigned SNAPSHOT_INDEX_MASK = 3;
+	constexpr unsigned SNAPSHOT_FRESH = 4;
+
+	Snapshot snapshots[ 3 ];
+	unsigned backSnapshot = 0;
+	std::atomic< unsigned > middleSnapshot( 1 );
+	unsigned frontSnapshot = 2;
+
+
+	Snapshot const &acquireSnapshot()
+	{
+		if ( middleSnapshot.load( std::memory_order_relaxed ) & SNAPSHOT_FRESH )
+			frontSnapshot = middleSnapshot.exchange( frontSnapshot, std::memory_order_acq_rel ) & SNAPSHOT_INDEX_MASK;
+		return snapshots[ frontSnapshot ];
 	}
 }
 
@@ -341,46 +870,404 @@ namespace scene
 {
 	namespace
 	{
+		constexpr int MESH_UPDATE_GRAIN = 64;
+		std::vector< std::vector< Particle > > meshSpawnedParticles;
+
 		constexpr float TIME_BETWEEN_SEA_PARTICLES = 0.02f;
 		float timeToNextSeaParticle = 0.f;
+		int maxSeaParticlesPerUpdate = 8;
 		std::default_random_engine seaParticlesRandomEngine( 42 );
 		std::uniform_real_distribution< float > seaParticlesHorizDistr( -0.5f * VIEW_WIDTH, 0.5f * VIEW_WIDTH );
 		std::uniform_real_distribution< float > seaParticlesVertDistr( -0.5f * VIEW_HEIGHT, 0.5f * VIEW_HEIGHT );
 	}
 
 
+	void setSpawnLimit( int maxSeaParticles )
+	{
+		assert( maxSeaParticles > 0 );
+		maxSeaParticlesPerUpdate = maxSeaParticles;
+	}
+
+
 	void update( float dt )
 	{
-		for ( Mesh *mesh : Mesh::meshes )
-			mesh->update( dt );
-		updateParticles( dt );
+		updateCamera( dt );
+		eraseDestroyedMeshes();
+		{
+			PROFILE_SCOPE( profiler::PHASE_TRANSFORMS );
+			updateWorldTransforms( meshTypes, render::MESH_TYPE_COUNT );
+		}
+		{
+			PROFILE_SCOPE( profiler::PHASE_MESH_UPDATE );
+			int chunkCount = 0;
+			for ( MeshArrays const *meshes : meshTypes )
+				chunkCount += ( meshes->size() + MESH_UPDATE_GRAIN - 1 ) / MESH_UPDATE_GRAIN;
+			meshSpawnedParticles.resize( chunkCount );
+
+			int firstChunk = 0;
+			for ( MeshArrays *meshes : meshTypes )
+			{
+				jobs::parallelFor( meshes->size(), MESH_UPDATE_GRAIN, [ meshes, firstChunk, dt ]( int begin, int end )
+				{
+					spawnedParticles = &meshSpawnedParticles[ firstChunk + begin / MESH_UPDATE_GRAIN ];
+					meshes->update( begin, end, dt );
+					spawnedParticles = nullptr;
+				} );
+				firstChunk += ( meshes->size() + MESH_UPDATE_GRAIN - 1 ) / MESH_UPDATE_GRAIN;
+			}
+			for ( std::vector< Particle > &spawned : meshSpawnedParticles )
+			{
+				particles.insert( particles.end(), spawned.begin(), spawned.end() );
+				spawned.clear();
+			}
+		}
+		{
+			PROFILE_SCOPE( profiler::PHASE_PARTICLE_UPDATE );
+			updateParticles( dt );
+		}
+		{
+			PROFILE_SCOPE( profiler::PHASE_SEA_PARTICLES );
+			timeToNextSeaParticle += dt;
+			for ( int spawned = 0; timeToNextSeaParticle > 0.f; ++spawned )
+			{
+				if ( spawned == maxSeaParticlesPerUpdate )
+				{
+					timeToNextSeaParticle = 0.f;
+					break;
+				}
+
+				// around the camera, the rest of the sea is not looked at
+				timeToNextSeaParticle -= TIME_BETWEEN_SEA_PARTICLES;
+				float x = seaParticlesHorizDistr( seaParticlesRandomEngine );
+				float y = seaParticlesVertDistr( seaParticlesRandomEngine );
+				addParticle( camera.x + x / camera.zoom, camera.y + y / camera.zoom, 3.f, Color{ 0.15f, 0.3f, 0.6f } );
+			}
+		}
+
+		for ( MeshArrays *meshes : meshTypes )
+		{
+			jobs::parallelFor( meshes->size(), MESH_UPDATE_GRAIN, [ meshes ]( int begin, int end )
+			{
+				meshes->endTick( begin, end );
+			} );
+		}
+	}
+
+
+	namespace
+	{
+		// owned by the simulation thread, kept to reuse their storage
+		std::vector< MeshSnapshot > unsortedMeshes;
+		std::vector< render::Vertex > unsortedParticles;
 
-		timeToNextSeaParticle += dt;
-		while ( timeToNextSeaParticle > 0.f )
+
+		void gatherMeshSnapshots( MeshArrays const &meshes, std::vector< MeshSnapshot > *snapshots )
 		{
-			timeToNextSeaParticle -= TIME_BETWEEN_SEA_PARTICLES;
-			addParticle( seaParticlesHorizDistr( seaParticlesRandomEngine ),
-						 seaParticlesVertDistr( seaParticlesRandomEngine ),
-						 3.f,
-						 Color{ 0.15f, 0.3f, 0.6f } );
+			for ( int i = 0; i < meshes.size(); ++i )
+			{
+				Transform const &from = meshes.previousTick[ i ];
+				Transform const &to = meshes.lastTick[ i ];
+				bool moved = from.positionX != to.positionX || from.positionY != to.positionY || from.angle != to.angle;
+				snapshots->push_back( MeshSnapshot{ meshes.type, moved, from, to } );
+			}
 		}
 	}
 
 
-	void draw()
+	void publishSnapshot( long long tick )
 	{
-		glMatrixMode( GL_PROJECTION );
-		glLoadIdentity();
-		glScalef( 2.f / VIEW_WIDTH, 2.f / VIEW_HEIGHT, 0.f );
+		PROFILE_SCOPE( profiler::PHASE_PUBLISH_SNAPSHOT );
+
+		Snapshot &snapshot = snapshots[ backSnapshot ];
+		snapshot.tick = tick;
+		snapshot.previousCamera = cameraPreviousUpdate;
+		snapshot.lastCamera = camera;
 
-		glDisable( GL_CULL_FACE );
-		glClearColor( 0.1f, 0.2f, 0.4f, 0.f );
-		glClear( GL_COLOR_BUFFER_BIT );
-		glMatrixMode( GL_MODELVIEW );
+		unsortedMeshes.clear();
+		for ( MeshArrays const *meshes : meshTypes )
+			gatherMeshSnapshots( *meshes, &unsortedMeshes );
+		snapshot.meshGrid.sort( unsortedMeshes, &snapshot.meshes, []( MeshSnapshot const &mesh, float *x, float *y )
+		{
+			*x = mesh.lastTick.positionX;
+			*y = mesh.lastTick.positionY;
+		} );
 
-		drawParticles();
-		for ( Mesh *mesh : Mesh::meshes )
-			mesh->draw();
-		drawGoalMarker();
+		unsortedParticles.clear();
+		for ( Particle const &particle : particles )
+			unsortedParticles.push_back( render::Vertex{ particle.x, particle.y, particle.color.r, particle.color.g, particle.color.b } );
+		snapshot.particleGrid.sort( unsortedParticles, &snapshot.particles, []( render::Vertex const &particle, float *x, float *y )
+		{
+			*x = particle.x;
+			*y = particle.y;
+		} );
+
+		snapshot.goalMarker = goalMarker;
+
+		backSnapshot = middleSnapshot.exchange( backSnapshot | SNAPSHOT_FRESH, std::memory_order_acq_rel ) & SNAPSHOT_INDEX_MASK;
+	}
+
+
+	namespace
+	{
+		// covers outline widths and point sizes, which are in pixels rather than world units
+		constexpr float CULL_MARGIN = 0.05f;
+
+		// meshes are indexed by their latest position, drawn between that and the one before, and
+		// reach out by their bounding radius; far more than that adds up to in a tick
+		constexpr float GRID_QUERY_MARGIN = 1.f;
+
+		// owned by the render thread, kept to reuse their storage
+		render::CommandBuffer commands;
+		std::vector< render::Vertex > visibleParticles;
+
+
+		bool isVisible( render::View const &view, float x, float y, float radius )
+		{
+			return std::abs( x - view.centerX ) <= view.width * 0.5f + radius + CULL_MARGIN
+				&& std::abs( y - view.centerY ) <= view.height * 0.5f + radius + CULL_MARGIN;
+		}
+
+
+		// visit( begin, end ) for the runs of grid sorted items in cells overlapping the view
+		template< class Visit >
+		int queryView( grid::UniformGrid const &grid, render::View const &view, float margin, Visit visit )
+		{
+			float halfWidth = view.width * 0.5f + margin;
+			float halfHeight = view.height * 0.5f + margin;
+			return grid.query( view.centerX - halfWidth, view.centerY - halfHeight, view.centerX + halfWidth, view.centerY + halfHeight, visit );
+		}
+	}
+
+
+	void draw( double renderTick, render::Renderer &renderer )
+	{
+		PROFILE_SCOPE( profiler::PHASE_SCENE_DRAW );
+
+		Snapshot const &snapshot = acquireSnapshot();
+		float interpolation = ( float )std::min( std::max( renderTick - snapshot.tick, 0.0 ), 1.0 );
+
+		Camera camera;
+		camera.x = snapshot.previousCamera.x + ( snapshot.lastCamera.x - snapshot.previousCamera.x ) * interpolation;
+		camera.y = snapshot.previousCamera.y + ( snapshot.lastCamera.y - snapshot.previousCamera.y ) * interpolation;
+		camera.zoom = snapshot.previousCamera.zoom + ( snapshot.lastCamera.zoom - snapshot.previousCamera.zoom ) * interpolation;
+		render::View view = cameraView( camera );
+
+		int cellsVisited = 0;
+		int meshesDrawn = 0;
+		int meshesMoved = 0;
+		commands.clear();
+		{
+			PROFILE_SCOPE( profiler::PHASE_DRAW_PARTICLES );
+			visibleParticles.clear();
+			cellsVisited += queryView( snapshot.particleGrid, view, 0.f, [ & ]( int begin, int end )
+			{
+				for ( int i = begin; i < end; ++i )
+					if ( isVisible( view, snapshot.particles[ i ].x, snapshot.particles[ i ].y, 0.f ) )
+						visibleParticles.push_back( snapshot.particles[ i ] );
+			} );
+			profiler::addCount( profiler::COUNTER_PARTICLES_CULLED, ( long long )( snapshot.particles.size() - visibleParticles.size() ) );
+			commands.drawParticles( render::LAYER_SEA, visibleParticles.data(), ( int )visibleParticles.size(), PARTICLE_SIZE );
+		}
+		{
+			PROFILE_SCOPE( profiler::PHASE_DRAW_MESHES );
+			// sorted by mesh type, ships come first so aircraft on deck stay on top
+			cellsVisited += queryView( snapshot.meshGrid, view, GRID_QUERY_MARGIN, [ & ]( int begin, int end )
+			{
+				for ( int i = begin; i < end; ++i )
+				{
+					MeshSnapshot const &mesh = snapshot.meshes[ i ];
+					Transform transform = mesh.moved ? interpolate( mesh.previousTick, mesh.lastTick, interpolation ) : mesh.lastTick;
+					if ( !isVisible( view, transform.positionX, transform.positionY, render::meshGeometry( mesh.type ).boundingRadius ) )
+						continue;
+					commands.drawMesh( render::LAYER_MESHES, mesh.type, render::Instance{ transform.positionX, transform.positionY, transform.angle } );
+					++meshesDrawn;
+					meshesMoved += mesh.moved ? 1 : 0;
+				}
+			} );
+			profiler::addCount( profiler::COUNTER_MESHES_CULLED, ( long long )snapshot.meshes.size() - meshesDrawn );
+			profiler::addCount( profiler::COUNTER_MESHES_DIRTY, meshesMoved );
+			profiler::addCount( profiler::COUNTER_MESHES_CLEAN, meshesDrawn - meshesMoved );
+		}
+		profiler::addCount( profiler::COUNTER_GRID_CELLS_VISITED, cellsVisited );
+		{
+			PROFILE_SCOPE( profiler::PHASE_DRAW_GOAL_MARKER );
+			drawGoalMarker( snapshot.goalMarker, commands );
+		}
+		hud::draw( commands, hud::SceneCounts{ ( int )snapshot.meshes.size(), meshesDrawn, ( int )snapshot.particles.size(), ( int )visibleParticles.size() } );
+
+		renderer.beginFrame( view, render::Color{ 0.1f, 0.2f, 0.4f } );
+		{
+			PROFILE_SCOPE( profiler::PHASE_EXECUTE_COMMANDS );
+			commands.execute( renderer );
+		}
+		renderer.endFrame();
+	}
+}
+
+
+//-------------------------------------------------------
+//	mesh storage benchmark
+//-------------------------------------------------------
+
+namespace
+{
+	// meshes as they used to be stored: pooled objects reached through a pointer each and
+	// updated through a virtual call each, kept to measure the type arrays against
+	class VirtualMesh
+	{
+	public:
+		explicit VirtualMesh( render::MeshType meshType ) : type( meshType ) {}
+		virtual ~VirtualMesh() = default;
+
+		render::MeshType const type;
+		float positionX = 0.f;
+		float positionY = 0.f;
+		float angle = 0.f;
+		scene::Transform previousTick = {};
+		scene::Transform lastTick = {};
+		bool ticked = false;
+		bool destroyed = false;
+
+		virtual void update( float dt ) {}
+
+		void endTick()
+		{
+			scene::Transform current = { positionX, positionY, angle };
+			previousTick = ticked ? lastTick : current;
+			lastTick = current;
+			ticked = true;
+		}
+	};
+
+
+	class VirtualShipMesh : public VirtualMesh
+	{
+	public:
+		VirtualShipMesh() : VirtualMesh( render::MESH_SHIP ) {}
+	};
+
+
+	class VirtualAircraftMesh : public VirtualMesh
+	{
+	public:
+		VirtualAircraftMesh() : VirtualMesh( render::MESH_AIRCRAFT ) {}
+
+		void update( float dt ) override
+		{
+			nextParticleTimeout -= dt;
+			if ( nextParticleTimeout <= 0.f )
+			{
+				nextParticleTimeout += 0.1f;
+				addParticle( positionX, positionY, 0.8f, Color{ 1.f, 1.f, 1.f } );
+			}
+		}
+
+	private:
+		float nextParticleTimeout = 0.f;
+	};
+
+
+	constexpr float BENCHMARK_TICK_TIME = 1.f / 60.f;
+
+
+	double millisecondsSince( long long start )
+	{
+		return 1000.0 * ( double )( platform::clockTicks() - start ) / ( double )platform::clockFrequency();
+	}
+}
+
+
+namespace scene
+{
+	MeshBenchmark benchmarkMeshStorage( int meshCount, int ticks )
+	{
+		assert( meshCount > 0 && ticks > 0 );
+
+		// five aircraft per ship as in the game, spread over the world; the pointers are shuffled,
+		// as launches and landings leave them after a while
+		std::default_random_engine random( 42 );
+		std::uniform_real_distribution< float > horizontal( -0.5f * WORLD_WIDTH, 0.5f * WORLD_WIDTH );
+		std::uniform_real_distribution< float > vertical( -0.5f * WORLD_HEIGHT, 0.5f * WORLD_HEIGHT );
+		std::uniform_real_distribution< float > angles( -3.14159265f, 3.14159265f );
+
+		memory::Pool< VirtualShipMesh > shipPool;
+		memory::Pool< VirtualAircraftMesh > aircraftPool;
+		std::vector< VirtualMesh* > virtualMeshes;
+		MeshArrays ships( render::MESH_SHIP );
+		AircraftMeshes aircraft;
+		MeshArrays *const types[] = { &ships, &aircraft };
+		for ( int i = 0; i < meshCount; ++i )
+		{
+			bool isShip = i % 6 == 0;
+			VirtualMesh *mesh;
+			if ( isShip )
+				mesh = new ( shipPool.allocate() ) VirtualShipMesh;
+			else
+				mesh = new ( aircraftPool.allocate() ) VirtualAircraftMesh;
+			MeshArrays &meshes = isShip ? ships : aircraft;
+			int index = meshes.add( containers::SlotHandle() );
+			meshes.positionX[ index ] = mesh->positionX = horizontal( random );
+			meshes.positionY[ index ] = mesh->positionY = vertical( random );
+			meshes.angle[ index ] = mesh->angle = angles( random );
+			meshes.world[ index ] = Transform{ mesh->positionX, mesh->positionY, mesh->angle };
+			virtualMeshes.push_back( mesh );
+		}
+		std::shuffle( virtualMeshes.begin(), virtualMeshes.end(), random );
+
+		// the work of update() and publishSnapshot() on meshes, on the calling thread only
+		std::vector< Particle > spawned;
+		std::vector< MeshSnapshot > snapshot;
+		spawnedParticles = &spawned;
+
+		MeshBenchmark result = {};
+		for ( int tick = 0; tick <= ticks; ++tick )
+		{
+			long long start = platform::clockTicks();
+			for ( VirtualMesh *mesh : virtualMeshes )
+				mesh->update( BENCHMARK_TICK_TIME );
+			for ( VirtualMesh *mesh : virtualMeshes )
+				mesh->endTick();
+			snapshot.clear();
+			for ( VirtualMesh const *mesh : virtualMeshes )
+				snapshot.push_back( MeshSnapshot{ mesh->type, true, mesh->previousTick, mesh->lastTick } );
+			spawned.clear();
+			double virtualTime = millisecondsSince( start );
+
+			start = platform::clockTicks();
+			for ( MeshArrays *meshes : types )
+				meshes->update( 0, meshes->size(), BENCHMARK_TICK_TIME );
+			for ( MeshArrays *meshes : types )
+				meshes->endTick( 0, meshes->size() );
+			snapshot.clear();
+			for ( MeshArrays const *meshes : types )
+				gatherMeshSnapshots( *meshes, &snapshot );
+			spawned.clear();
+			double typeArraysTime = millisecondsSince( start );
+
+			// the first tick warms caches and grows the scratch vectors
+			if ( tick > 0 )
+			{
+				result.virtualDispatch += virtualTime / ticks;
+				result.typeArrays += typeArraysTime / ticks;
+			}
+		}
+
+		spawnedParticles = nullptr;
+		for ( VirtualMesh *mesh : virtualMeshes )
+		{
+			if ( mesh->type == render::MESH_SHIP )
+			{
+				VirtualShipMesh *ship = static_cast< VirtualShipMesh* >( mesh );
+				ship->~VirtualShipMesh();
+				shipPool.free( ship );
+			}
+			else
+			{
+				VirtualAircraftMesh *plane = static_cast< VirtualAircraftMesh* >( mesh );
+				plane->~VirtualAircraftMesh();
+				aircraftPool.free( plane );
+			}
+		}
+		return result;
 	}
 }
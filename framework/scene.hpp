@@ -6,13 +6,35 @@
 
 namespace scene
 {
-	class Mesh;
+	// generational, so a handle kept after destroyMesh() is detected as stale instead of dangling;
+	// the default handle is no mesh
+	struct MeshHandle
+	{
+		unsigned index = 0;
+		unsigned generation = 0;
+	};
 
-	Mesh *createShipMesh();
-	Mesh *createAircraftMesh();
-	void destroyMesh( Mesh *mesh );
-	void placeMesh( Mesh *mesh, float x, float y, float angle );
+	MeshHandle createShipMesh();
+	MeshHandle createAircraftMesh();
 
+	// room for that many more live meshes of each type, so creating them does not touch the heap
+	void reserveMeshes( int ships, int aircraft );
+
+	// may be called from parallel game updates, the mesh is removed at the start of the next update()
+	void destroyMesh( MeshHandle mesh );
+	// relative to the parent for attached meshes, in the world otherwise
+	void placeMesh( MeshHandle mesh, float x, float y, float angle );
+
+	// the child moves along with the parent from then on, both keep their place in the world until
+	// placed again; detaching leaves the mesh where it last was in the world. Either may be called
+	// from parallel game updates, destroying a mesh detaches its children
+	void attachMesh( MeshHandle child, MeshHandle parent );
+	void detachMesh( MeshHandle child );
+
+	// false once destroyed
+	bool isMeshAlive( MeshHandle mesh );
+
+	// through the camera as of the latest update()
 	void screenToWorld( float *x, float *y );
 
 	void placeGoalMarker( float x, float y );
@@ -23,8 +45,48 @@ namespace scene
 //	engine only interface
 //-------------------------------------------------------
 
+namespace render
+{
+	class Renderer;
+}
+
+
 namespace scene
 {
+	// held keys pan and zoom the camera a little every update()
+	enum CameraKey
+	{
+		CAMERA_PAN_LEFT,
+		CAMERA_PAN_RIGHT,
+		CAMERA_PAN_UP,
+		CAMERA_PAN_DOWN,
+		CAMERA_ZOOM_IN,
+		CAMERA_ZOOM_OUT,
+		CAMERA_KEY_COUNT
+	};
+
+	void cameraKeyPressed( int key );
+	void cameraKeyReleased( int key );
+
 	void update( float dt );
-	void draw();
+
+	// sea particles owed for longer than that many spawns in one update() are dropped
+	void setSpawnLimit( int maxSeaParticlesPerUpdate );
+
+	// copies what is needed for drawing, called on the simulation thread after update()
+	void publishSnapshot( long long tick );
+
+	// draws the latest published snapshot and may run concurrently with update(),
+	// renderTick is the simulation time in ticks used to blend the snapshot with the tick before it
+	void draw( double renderTick, render::Renderer &renderer );
+
+	// milliseconds per tick spent on the mesh part of update() and publishSnapshot()
+	struct MeshBenchmark
+	{
+		double virtualDispatch;		// a pooled object and a virtual call per mesh, as meshes used to be stored
+		double typeArrays;			// the arrays per mesh type the scene keeps them in
+	};
+
+	// on the calling thread, with meshCount meshes of its own next to the scene's
+	MeshBenchmark benchmarkMeshStorage( int meshCount, int ticks );
 }
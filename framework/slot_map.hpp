@@ -0,0 +1,140 @@
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	generational slot map
+//-------------------------------------------------------
+
+namespace containers
+{
+	// a slot index and the generation it was handed out in; the default handle is never valid
+	struct SlotHandle
+	{
+		std::uint32_t index = 0;
+		std::uint32_t generation = 0;
+
+		explicit operator bool() const { return generation != 0; }
+	};
+
+	inline bool operator == ( SlotHandle a, SlotHandle b ) { return a.index == b.index && a.generation == b.generation; }
+	inline bool operator != ( SlotHandle a, SlotHandle b ) { return !( a == b ); }
+
+
+	// values are kept densely packed for iteration, slots map handles to them; insert, erase and
+	// lookup take constant time, erasing moves the last value into the hole, and a slot's
+	// generation moves on when its value is erased so handles to it are detected as stale
+	template< class Value >
+	class SlotMap
+	{
+	public:
+		SlotHandle insert( Value value );
+		void erase( SlotHandle handle );
+
+		bool contains( SlotHandle handle ) const;
+		Value *find( SlotHandle handle );		// null for stale handles
+
+		int size() const { return ( int )values.size(); }
+		Value &operator [] ( int denseIndex ) { return values[ denseIndex ]; }
+		Value const &operator [] ( int denseIndex ) const { return values[ denseIndex ]; }
+		typename std::vector< Value >::iterator begin() { return values.begin(); }
+		typename std::vector< Value >::iterator end() { return values.end(); }
+		typename std::vector< Value >::const_iterator begin() const { return values.begin(); }
+		typename std::vector< Value >::const_iterator end() const { return values.end(); }
+
+		// storage for that many values without reallocating
+		void reserve( int count );
+
+	private:
+		static constexpr std::uint32_t NO_SLOT = 0xffffffff;
+
+		struct Slot
+		{
+			std::uint32_t generation;
+			std::uint32_t target;		// dense index while in use, next free slot otherwise
+		};
+
+		std::vector< Slot > slots;
+		std::vector< Value > values;
+		std::vector< std::uint32_t > valueSlots;		// the slot of each dense value
+		std::uint32_t firstFreeSlot = NO_SLOT;
+	};
+
+
+	//-------------------------------------------------------
+	template< class Value >
+	SlotHandle SlotMap< Value >::insert( Value value )
+	{
+		std::uint32_t index = firstFreeSlot;
+		if ( index == NO_SLOT )
+		{
+			index = ( std::uint32_t )slots.size();
+			slots.push_back( Slot{ 1, 0 } );
+		}
+		else
+		{
+			firstFreeSlot = slots[ index ].target;
+		}
+
+		Slot &slot = slots[ index ];
+		slot.target = ( std::uint32_t )values.size();
+		values.push_back( std::move( value ) );
+		valueSlots.push_back( index );
+
+		SlotHandle handle;
+		handle.index = index;
+		handle.generation = slot.generation;
+		return handle;
+	}
+
+
+	//-------------------------------------------------------
+	template< class Value >
+	void SlotMap< Value >::erase( SlotHandle handle )
+	{
+		assert( contains( handle ) );
+		Slot &slot = slots[ handle.index ];
+		std::uint32_t hole = slot.target;
+		std::uint32_t last = ( std::uint32_t )values.size() - 1;
+		if ( hole != last )
+		{
+			values[ hole ] = std::move( values[ last ] );
+			valueSlots[ hole ] = valueSlots[ last ];
+			slots[ valueSlots[ hole ] ].target = hole;
+		}
+		values.pop_back();
+		valueSlots.pop_back();
+
+		// zero is the invalid generation, skipped when it wraps around
+		slot.generation = slot.generation + 1 ? slot.generation + 1 : 1;
+		slot.target = firstFreeSlot;
+		firstFreeSlot = handle.index;
+	}
+
+
+	//-------------------------------------------------------
+	template< class Value >
+	bool SlotMap< Value >::contains( SlotHandle handle ) const
+	{
+		return handle.index < slots.size() && handle.generation != 0 && slots[ handle.index ].generation == handle.generation;
+	}
+
+
+	//-------------------------------------------------------
+	template< class Value >
+	Value *SlotMap< Value >::find( SlotHandle handle )
+	{
+		return contains( handle ) ? &values[ slots[ handle.index ].target ] : nullptr;
+	}
+
+
+	//-------------------------------------------------------
+	template< class Value >
+	void SlotMap< Value >::reserve( int count )
+	{
+		slots.reserve( count );
+		values.reserve( count );
+		valueSlots.reserve( count );
+	}
+}
@@ -5,6 +5,7 @@
 
 #include "../framework/scene.hpp"
 #include "../framework/game.hpp"
+#include "../framework/jobs.hpp"
 
 
 //-------------------------------------------------------
@@ -25,6 +26,7 @@ namespace params
 		constexpr float ANGULAR_SPEED = 2.5f;
 		constexpr float FLIGHT_TIME = 10.f;
 		constexpr float REFUEL_TIME = 3.f;
+		constexpr int UPDATE_GRAIN = 64;		// aircraft per job
 	}
 
 	constexpr float PI = 3.14159265358979f;
@@ -133,8 +135,8 @@ protected:
 	void simulateFlight( float dt );
 
 private:
-	scene::Mesh *mesh;
-	Vector2 position;
+	scene::MeshHandle mesh;
+	Vector2 position;		// relative to the ship while on deck
 	float angle;
 	float acceleration;
 	float linearSpeed;
@@ -171,9 +173,10 @@ public:
 	Vector2 getPosition() const { return position; }
 	float getAngle() const { return angle; }
 	float getLinearSpeed() const { return linearSpeed; }
+	scene::MeshHandle getMesh() const { return mesh; }
 
 private:
-	scene::Mesh *mesh;
+	scene::MeshHandle mesh;
 	Vector2 position;
 	float angle;
 	float linearSpeed;
@@ -188,8 +191,7 @@ private:
 //	Simple aircraft logic
 //-------------------------------------------------------
 
-Aircraft::Aircraft() :
-	mesh( nullptr )
+Aircraft::Aircraft()
 {
 }
 
@@ -216,7 +218,7 @@ void Aircraft::init( Ship *owner )
 void Aircraft::deinit()
 {
 	scene::destroyMesh( mesh );
-	mesh = nullptr;
+	mesh = scene::MeshHandle();
 }
 
 
@@ -267,9 +269,11 @@ bool Aircraft::inFlight() const
 
 void Aircraft::launch()
 {
+	// carried by the ship until off the deck
 	mesh = scene::createAircraftMesh();
-	position = owningShip->getPosition();
-	angle = owningShip->getAngle();
+	scene::attachMesh( mesh, owningShip->getMesh() );
+	position = Vector2( 0.f, 0.f );
+	angle = 0.f;
 	scene::placeMesh( mesh, position.x, position.y, angle );
 
 	state = AircraftState::TAKEOFF;
@@ -278,12 +282,21 @@ void Aircraft::launch()
 
 void Aircraft::takeoff( float dt )
 {
+	position = position + linearSpeed * dt * Vector2( 1.f, 0.f );
+
 	if ( flightTime >= takeoffTime )
+	{
 		state = AircraftState::FLY;
 
-	angle = owningShip->getAngle();
-	float speed = linearSpeed + owningShip->getLinearSpeed();
-	position = position + speed * dt * Vector2( std::cos(angle), std::sin(angle) );
+		// off the deck, placed in the world from now on
+		Vector2 shipPosition = owningShip->getPosition();
+		float shipAngle = owningShip->getAngle();
+		float c = std::cos( shipAngle );
+		float s = std::sin( shipAngle );
+		position = shipPosition + Vector2( c * position.x - s * position.y, s * position.x + c * position.y );
+		angle = angle + shipAngle;
+		scene::detachMesh( mesh );
+	}
 }
 
 
@@ -332,6 +345,7 @@ void Aircraft::land( float dt )
 		state = AircraftState::REFUEL;
 		landingTime = flightTime;
 		scene::destroyMesh( mesh );
+		mesh = scene::MeshHandle();
 	}
 
 	angle = std::atan2( landingPos.y - position.y, landingPos.x - position.x );
@@ -373,15 +387,14 @@ void Aircraft::simulateFlight( float dt )
 //	Simple ship logic
 //-------------------------------------------------------
 
-Ship::Ship() :
-	mesh( nullptr )
+Ship::Ship()
 {
 }
 
 
 void Ship::init( std::array< Aircraft, 5 > *aircrafts )
 {
-	assert( !mesh );
+	assert( !scene::isMeshAlive( mesh ) );
 	mesh = scene::createShipMesh();
 	position = Vector2( 0.f, 0.f );
 	angle = 0.f;
@@ -395,7 +408,7 @@ void Ship::init( std::array< Aircraft, 5 > *aircrafts )
 void Ship::deinit()
 {
 	scene::destroyMesh( mesh );
-	mesh = nullptr;
+	mesh = scene::MeshHandle();
 }
 
 
@@ -475,6 +488,9 @@ namespace game
 
 	void init()
 	{
+		// launch and land only recycle these afterwards
+		scene::reserveMeshes( 1, ( int )planes.size() );
+
 		ship.init( &planes );
 		for ( Aircraft &plane : planes )
 			plane.init( &ship );
@@ -493,8 +509,13 @@ namespace game
 	void update( float dt )
 	{
 		ship.update( dt );
-		for ( Aircraft &plane : planes )
-			plane.update( dt );
+
+		// aircraft only read the already updated ship and write their own state
+		jobs::parallelFor( ( int )planes.size(), params::aircraft::UPDATE_GRAIN, [ dt ]( int begin, int end )
+		{
+			for ( int i = begin; i < end; ++i )
+				planes[ i ].update( dt );
+		} );
 	}
 
 
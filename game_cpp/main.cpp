@@ -1,10 +1,148 @@
-
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 #include "../framework/engine.hpp"
+#include "../framework/profiler.hpp"
+#include "../framework/scene.hpp"
 
 
-int main()
+void reportProfile( char const *basePath )
 {
-	engine::run();
+	for ( int track = 0; track < profiler::TRACK_COUNT; ++track )
+	{
+		for ( int phase = 0; phase < profiler::PHASE_COUNT; ++phase )
+		{
+			profiler::Summary summary = profiler::summarize( ( profiler::Track )track, ( profiler::Phase )phase );
+			if ( summary.frames == 0 )
+				continue;
+			std::printf( "%-10s %-24s p50: %8.3f ms, p99: %8.3f ms, max: %8.3f ms\n",
+						 profiler::trackName( ( profiler::Track )track ), profiler::phaseName( ( profiler::Phase )phase ),
+						 summary.p50, summary.p99, summary.max );
+		}
+		for ( int counter = 0; counter < profiler::COUNTER_COUNT; ++counter )
+		{
+			profiler::CounterSummary summary = profiler::summarize( ( profiler::Track )track, ( profiler::Counter )counter );
+			if ( summary.frames == 0 )
+				continue;
+			std::printf( "%-10s %-24s mean: %10.1f, max: %10lld\n",
+						 profiler::trackName( ( profiler::Track )track ), profiler::counterName( ( profiler::Counter )counter ),
+						 summary.mean, summary.max );
+		}
+	}
+
+	std::string path = basePath;
+	if ( !profiler::exportCsv( ( path + ".csv" ).c_str() ) )
+		std::printf( "failed to write %s.csv\n", basePath );
+	if ( !profiler::exportChromeTrace( ( path + ".json" ).c_str() ) )
+		std::printf( "failed to write %s.json\n", basePath );
+}
+
+
+int main( int argc, char **argv )
+{
+	int headlessTicks = -1;
+	float headlessDuration = -1.f;
+	char const *profilePath = nullptr;
+	char const *replayPath = nullptr;
+	int benchmarkMeshes = 0;
+	engine::RunSettings settings;
+	engine::HeadlessRendering rendering;
+
+	for ( int i = 1; i < argc; ++i )
+	{
+		if ( std::strcmp( argv[ i ], "-offscreen" ) == 0 )
+			settings.offscreen = true;
+		else if ( std::strcmp( argv[ i ], "-hud" ) == 0 )
+			engine::setHudVisible( true );
+		else if ( i + 1 == argc )
+			break;
+		else if ( std::strcmp( argv[ i ], "-headless" ) == 0 )
+			headlessTicks = std::atoi( argv[ ++i ] );
+		else if ( std::strcmp( argv[ i ], "-headless-duration" ) == 0 )
+			headlessDuration = ( float )std::atof( argv[ ++i ] );
+		else if ( std::strcmp( argv[ i ], "-profile" ) == 0 )
+			profilePath = argv[ ++i ];
+		else if ( std::strcmp( argv[ i ], "-frames" ) == 0 )
+			settings.frameLimit = std::atoi( argv[ ++i ] );
+		else if ( std::strcmp( argv[ i ], "-record" ) == 0 )
+			settings.recordPath = argv[ ++i ];
+		else if ( std::strcmp( argv[ i ], "-renderer" ) == 0 )
+			settings.renderer = std::strcmp( argv[ ++i ], "core" ) == 0 ? engine::RENDERER_CORE : engine::RENDERER_LEGACY;
+		else if ( std::strcmp( argv[ i ], "-capture" ) == 0 )
+			settings.capturePath = argv[ ++i ];
+		else if ( std::strcmp( argv[ i ], "-replay" ) == 0 )
+			replayPath = argv[ ++i ];
+		else if ( std::strcmp( argv[ i ], "-render-every" ) == 0 )
+			rendering.interval = std::atoi( argv[ ++i ] );
+		else if ( std::strcmp( argv[ i ], "-render-out" ) == 0 )
+			rendering.path = argv[ ++i ];
+		else if ( std::strcmp( argv[ i ], "-bench-meshes" ) == 0 )
+			benchmarkMeshes = std::atoi( argv[ ++i ] );
+	}
+
+	if ( benchmarkMeshes > 0 )
+	{
+		scene::MeshBenchmark benchmark = scene::benchmarkMeshStorage( benchmarkMeshes, 200 );
+		std::printf( "meshes: %d, virtual dispatch: %.3f ms, type arrays: %.3f ms per tick, speedup: %.2fx\n",
+					 benchmarkMeshes, benchmark.virtualDispatch, benchmark.typeArrays,
+					 benchmark.typeArrays > 0.0 ? benchmark.virtualDispatch / benchmark.typeArrays : 0.0 );
+		return 0;
+	}
+
+	if ( headlessTicks < 0 && headlessDuration < 0.f && !replayPath )
+	{
+		if ( !engine::run( settings ) )
+		{
+			std::printf( "failed to create the window or the OpenGL context, or to write the recording\n" );
+			return 1;
+		}
+
+		engine::PacingStats pacing = engine::getPacingStats();
+		std::printf( "frames: %d, target: %.3f ms, mean: %.3f ms, jitter: %.3f ms, max deviation: %.3f ms, slept: %.2f s, spun: %.2f s\n",
+					 pacing.frames, pacing.targetFrameTime * 1000.0, pacing.meanFrameTime * 1000.0,
+					 pacing.jitter * 1000.0, pacing.maxDeviation * 1000.0, pacing.sleepTime, pacing.spinTime );
+		engine::InputStats input = engine::getInputStats();
+		std::printf( "input events: %d, dropped: %d, mean latency: %.3f ms, max latency: %.3f ms\n",
+					 input.events, input.dropped, input.meanLatency * 1000.0, input.maxLatency * 1000.0 );
+		engine::TimeStepStats timeStep = engine::getTimeStepStats();
+		std::printf( "split ticks: %d, catch-up ticks: %d, dropped: %.3f s\n",
+					 timeStep.splitTicks, timeStep.catchUpTicks, timeStep.droppedTime );
+		if ( settings.capturePath )
+		{
+			engine::CaptureStats capture = engine::getCaptureStats();
+			std::printf( "captured frames: %d, written: %d, dropped: %d, failed: %d\n",
+						 capture.frames, capture.written, capture.dropped, capture.failed );
+		}
+		if ( profilePath )
+			reportProfile( profilePath );
+		return 0;
+	}
+
+	if ( rendering.path && rendering.interval <= 0 )
+		rendering.interval = 1;
+	engine::setHeadlessRendering( rendering );
+
+	engine::HeadlessStats stats;
+	if ( replayPath )
+	{
+		if ( !engine::runReplay( replayPath, &stats ) )
+		{
+			std::printf( "failed to read %s\n", replayPath );
+			return 1;
+		}
+	}
+	else
+		stats = headlessTicks >= 0 ? engine::runHeadless( headlessTicks ) : engine::runHeadlessFor( headlessDuration );
+
+	std::printf( "ticks: %d, simulated: %.3f s, wall: %.3f s, speedup: %.1fx, %.0f ticks/s\n",
+				 stats.ticks, stats.simulatedTime, stats.wallTime,
+				 stats.wallTime > 0.0 ? stats.simulatedTime / stats.wallTime : 0.0,
+				 stats.wallTime > 0.0 ? stats.ticks / stats.wallTime : 0.0 );
+	if ( stats.imagesFailed > 0 )
+		std::printf( "failed to write %d images to %s\n", stats.imagesFailed, rendering.path );
+	if ( profilePath )
+		reportProfile( profilePath );
 	return 0;
 }